@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "lib.h"
 #include "allocate.h"
@@ -43,9 +44,12 @@
 #include "expression.h"
 #include "linearize.h"
 
+struct allocator_struct *all_allocators;
+
 void protect_allocations(struct allocator_struct *desc)
 {
 	desc->blobs = NULL;
+	desc->last_blob = NULL;
 }
 
 void drop_all_allocations(struct allocator_struct *desc)
@@ -53,6 +57,7 @@ void drop_all_allocations(struct allocator_struct *desc)
 	struct allocation_blob *blob = desc->blobs;
 
 	desc->blobs = NULL;
+	desc->last_blob = NULL;
 	desc->allocations = 0;
 	desc->total_bytes = 0;
 	desc->useful_bytes = 0;
@@ -64,6 +69,55 @@ void drop_all_allocations(struct allocator_struct *desc)
 	}
 }
 
+/*
+ * Like drop_all_allocations() but the blobs are kept on the spare list so
+ * the next allocations don't have to go back to the system.  It's O(1).
+ */
+void recycle_all_allocations(struct allocator_struct *desc)
+{
+	if (desc->blobs) {
+		desc->last_blob->next = desc->spare;
+		desc->spare = desc->blobs;
+	}
+	desc->blobs = NULL;
+	desc->last_blob = NULL;
+	desc->allocations = 0;
+	desc->total_bytes = 0;
+	desc->useful_bytes = 0;
+	desc->freelist = NULL;
+}
+
+void reset_arena(struct allocator_arena *arena)
+{
+	struct allocator_struct *desc;
+
+	for (desc = arena->allocators; desc; desc = desc->next_in_arena)
+		recycle_all_allocations(desc);
+}
+
+static struct allocation_blob *get_blob(struct allocator_struct *desc)
+{
+	struct allocation_blob *blob = desc->spare;
+
+	if (!blob) {
+		if (!desc->registered) {
+			desc->next_allocator = all_allocators;
+			all_allocators = desc;
+			if (desc->arena) {
+				desc->next_in_arena = desc->arena->allocators;
+				desc->arena->allocators = desc;
+			}
+			desc->registered = 1;
+		}
+		return blob_alloc(desc->chunking);
+	}
+
+	/* new blobs come from mmap() so they are zeroed.  Keep it that way. */
+	desc->spare = blob->next;
+	memset(blob->data, 0, blob->offset);
+	return blob;
+}
+
 void free_one_entry(struct allocator_struct *desc, void *entry)
 {
 	void **p = entry;
@@ -100,10 +154,12 @@ void *allocate(struct allocator_struct *desc, unsigned int size)
 	size = (size + alignment - 1) & ~(alignment-1);
 	if (!blob || blob->left < size) {
 		unsigned int offset, chunking = desc->chunking;
-		struct allocation_blob *newblob = blob_alloc(chunking);
+		struct allocation_blob *newblob = get_blob(desc);
 		if (!newblob)
 			die("out of memory");
 		desc->total_bytes += chunking;
+		if (!blob)
+			desc->last_blob = newblob;
 		newblob->next = blob;
 		blob = newblob;
 		desc->blobs = newblob;
@@ -7,6 +7,18 @@ struct allocation_blob {
 	unsigned char data[];
 };
 
+struct allocator_struct;
+
+/*
+ * An arena groups allocators that share a lifetime so they can all be
+ * reset at once.  The blobs of a reset allocator are kept for reuse
+ * instead of being handed back to the system.
+ */
+struct allocator_arena {
+	const char *name;
+	struct allocator_struct *allocators;
+};
+
 struct allocator_struct {
 	const char *name;
 	struct allocation_blob *blobs;
@@ -15,10 +27,22 @@ struct allocator_struct {
 	void *freelist;
 	/* statistics */
 	unsigned int allocations, total_bytes, useful_bytes;
+	struct allocator_struct *next_allocator;
+	int registered;
+	/* arena support */
+	struct allocator_arena *arena;
+	struct allocator_struct *next_in_arena;
+	struct allocation_blob *last_blob;
+	struct allocation_blob *spare;
 };
 
+/* every allocator which has asked for memory at least once */
+extern struct allocator_struct *all_allocators;
+
 extern void protect_allocations(struct allocator_struct *desc);
 extern void drop_all_allocations(struct allocator_struct *desc);
+extern void recycle_all_allocations(struct allocator_struct *desc);
+extern void reset_arena(struct allocator_arena *arena);
 extern void *allocate(struct allocator_struct *desc, unsigned int size);
 extern void free_one_entry(struct allocator_struct *desc, void *entry);
 extern void show_allocations(struct allocator_struct *);
@@ -31,11 +55,12 @@ extern void show_allocations(struct allocator_struct *);
 	extern void protect_##x##_alloc(void);
 #define DECLARE_ALLOCATOR(x) __DECLARE_ALLOCATOR(struct x, x)
 
-#define __DO_ALLOCATOR(type, objsize, objalign, objname, x)	\
+#define __DO_ARENA_ALLOCATOR(type, objsize, objalign, objname, x, a)	\
 	static struct allocator_struct x##_allocator = {	\
 		.name = objname,				\
 		.alignment = objalign,				\
-		.chunking = CHUNK };				\
+		.chunking = CHUNK,				\
+		.arena = a };					\
 	type *__alloc_##x(int extra)				\
 	{							\
 		return allocate(&x##_allocator, objsize+extra);	\
@@ -57,11 +82,19 @@ extern void show_allocations(struct allocator_struct *);
 		protect_allocations(&x##_allocator);		\
 	}
 
+#define __DO_ALLOCATOR(type, objsize, objalign, objname, x)	\
+	__DO_ARENA_ALLOCATOR(type, objsize, objalign, objname, x, NULL)
+
 #define __ALLOCATOR(t, n, x) 					\
 	__DO_ALLOCATOR(t, sizeof(t), __alignof__(t), n, x)
 
 #define ALLOCATOR(x, n) __ALLOCATOR(struct x, n, x)
 
+#define __ARENA_ALLOCATOR(t, n, x, a)				\
+	__DO_ARENA_ALLOCATOR(t, sizeof(t), __alignof__(t), n, x, a)
+
+#define ARENA_ALLOCATOR(x, n, a) __ARENA_ALLOCATOR(struct x, n, x, a)
+
 DECLARE_ALLOCATOR(ident);
 DECLARE_ALLOCATOR(token);
 DECLARE_ALLOCATOR(context);
@@ -29,49 +29,184 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <assert.h>
-#include <libxml/parser.h>
-#include <libxml/tree.h>
 
 #include "expression.h"
 #include "parse.h"
 #include "scope.h"
 #include "symbol.h"
 
-static xmlDocPtr doc = NULL;       /* document pointer */
-static xmlNodePtr root_node = NULL;/* root node pointer */
+/*
+ * The document is written out as we go instead of being built in memory
+ * first.  The output is formatted the same way libxml did it.
+ *
+ * A symbol's base type is added to the top level as soon as we find it,
+ * which is usually while the symbol itself is only half written.  So every
+ * top level element gets its own buffer and the buffers are written out in
+ * order as soon as they are complete.  Only the elements which are still
+ * being worked on are held in memory.
+ */
+struct toplevel {
+	char *buf;
+	size_t len, alloc;
+	int done;
+	struct toplevel *next;
+};
+
+struct element {
+	struct toplevel *out;
+	int depth;
+	int has_children;
+};
+
+static struct toplevel *pending, **pending_tail = &pending;
+static int root_has_children;
 static int idcount = 0;
 
-static void examine_symbol(struct symbol *sym, xmlNodePtr node);
+static void examine_symbol(struct symbol *sym, struct element *parent);
+
+static void out_mem(struct toplevel *out, const char *str, size_t len)
+{
+	if (out->len + len > out->alloc) {
+		out->alloc = (out->len + len) * 2;
+		out->buf = realloc(out->buf, out->alloc);
+		if (!out->buf)
+			die("out of memory");
+	}
+	memcpy(out->buf + out->len, str, len);
+	out->len += len;
+}
+
+static void out_str(struct toplevel *out, const char *str)
+{
+	out_mem(out, str, strlen(str));
+}
+
+static void out_indent(struct toplevel *out, int depth)
+{
+	while (depth--)
+		out_mem(out, "  ", 2);
+}
 
-static xmlAttrPtr newProp(xmlNodePtr node, const char *name, const char *value)
+static void out_escaped(struct toplevel *out, const char *str)
 {
-	return xmlNewProp(node, BAD_CAST name, BAD_CAST value);
+	const char *p;
+
+	for (p = str; *p; p++) {
+		switch (*p) {
+		case '<':
+			out_str(out, "&lt;");
+			break;
+		case '>':
+			out_str(out, "&gt;");
+			break;
+		case '&':
+			out_str(out, "&amp;");
+			break;
+		case '"':
+			out_str(out, "&quot;");
+			break;
+		case '\n':
+			out_str(out, "&#10;");
+			break;
+		case '\r':
+			out_str(out, "&#13;");
+			break;
+		case '\t':
+			out_str(out, "&#9;");
+			break;
+		default:
+			out_mem(out, p, 1);
+		}
+	}
 }
 
-static xmlAttrPtr newNumProp(xmlNodePtr node, const char *name, int value)
+static void flush_pending(void)
+{
+	struct toplevel *out;
+
+	while (pending && pending->done) {
+		out = pending;
+		if (!root_has_children) {
+			fputs(">\n", stdout);
+			root_has_children = 1;
+		}
+		fwrite(out->buf, 1, out->len, stdout);
+		pending = out->next;
+		if (!pending)
+			pending_tail = &pending;
+		free(out->buf);
+		free(out);
+	}
+}
+
+static void open_element(struct element *elem, struct element *parent)
+{
+	struct toplevel *out;
+
+	if (!parent) {
+		out = calloc(1, sizeof(*out));
+		if (!out)
+			die("out of memory");
+		*pending_tail = out;
+		pending_tail = &out->next;
+		elem->out = out;
+		elem->depth = 1;
+	} else {
+		if (!parent->has_children)
+			out_str(parent->out, ">\n");
+		parent->has_children = 1;
+		elem->out = parent->out;
+		elem->depth = parent->depth + 1;
+	}
+	elem->has_children = 0;
+	out_indent(elem->out, elem->depth);
+	out_str(elem->out, "<symbol");
+}
+
+static void close_element(struct element *elem)
+{
+	if (elem->has_children) {
+		out_indent(elem->out, elem->depth);
+		out_str(elem->out, "</symbol>\n");
+	} else {
+		out_str(elem->out, "/>\n");
+	}
+	if (elem->depth == 1) {
+		elem->out->done = 1;
+		flush_pending();
+	}
+}
+
+static void newProp(struct element *node, const char *name, const char *value)
+{
+	out_str(node->out, " ");
+	out_str(node->out, name);
+	out_str(node->out, "=\"");
+	out_escaped(node->out, value);
+	out_str(node->out, "\"");
+}
+
+static void newNumProp(struct element *node, const char *name, int value)
 {
 	char buf[256];
 	snprintf(buf, 256, "%d", value);
-	return newProp(node, name, buf);
+	newProp(node, name, buf);
 }
 
-static xmlAttrPtr newIdProp(xmlNodePtr node, const char *name, unsigned int id)
+static void newIdProp(struct element *node, const char *name, unsigned int id)
 {
 	char buf[256];
 	snprintf(buf, 256, "_%d", id);
-	return newProp(node, name, buf);
+	newProp(node, name, buf);
 }
 
-static xmlNodePtr new_sym_node(struct symbol *sym, const char *name, xmlNodePtr parent)
+/* ->aux is the id of the symbol plus one once it has been written */
+static void new_sym_node(struct symbol *sym, const char *name, struct element *node)
 {
-	xmlNodePtr node;
 	const char *ident = show_ident(sym->ident);
 
 	assert(name != NULL);
 	assert(sym != NULL);
-	assert(parent != NULL);
-
-	node = xmlNewChild(parent, NULL, BAD_CAST "symbol", NULL);
 
 	newProp(node, "type", name);
 
@@ -90,14 +225,12 @@ static xmlNodePtr new_sym_node(struct symbol *sym, const char *name, xmlNodePtr
 		if (sym->pos.stream != sym->endpos.stream)
 			newProp(node, "end-file", stream_name(sym->endpos.stream));
         }
-	sym->aux = node;
+	sym->aux = (void *)(unsigned long)(idcount + 1);
 
 	idcount++;
-
-	return node;
 }
 
-static inline void examine_members(struct symbol_list *list, xmlNodePtr node)
+static inline void examine_members(struct symbol_list *list, struct element *node)
 {
 	struct symbol *sym;
 
@@ -106,7 +239,7 @@ static inline void examine_members(struct symbol_list *list, xmlNodePtr node)
 	} END_FOR_EACH_PTR(sym);
 }
 
-static void examine_modifiers(struct symbol *sym, xmlNodePtr node)
+static void examine_modifiers(struct symbol *sym, struct element *node)
 {
 	const char *modifiers[] = {
 			"auto",
@@ -155,7 +288,7 @@ static void examine_modifiers(struct symbol *sym, xmlNodePtr node)
 }
 
 static void
-examine_layout(struct symbol *sym, xmlNodePtr node)
+examine_layout(struct symbol *sym, struct element *node)
 {
 	examine_symbol_type(sym);
 
@@ -167,10 +300,12 @@ examine_layout(struct symbol *sym, xmlNodePtr node)
 	}
 }
 
-static void examine_symbol(struct symbol *sym, xmlNodePtr node)
+static void examine_symbol(struct symbol *sym, struct element *node)
 {
-	xmlNodePtr child = NULL;
+	struct element elem;
+	struct element *child = &elem;
 	const char *base;
+	char buf[256];
 	int array_size;
 
 	if (!sym)
@@ -181,17 +316,21 @@ static void examine_symbol(struct symbol *sym, xmlNodePtr node)
 	if (sym->ident && sym->ident->reserved)
 		return;
 
-	child = new_sym_node(sym, get_type_name(sym->type), node);
+	open_element(child, node);
+	new_sym_node(sym, get_type_name(sym->type), child);
 	examine_modifiers(sym, child);
 	examine_layout(sym, child);
 
 	if (sym->ctype.base_type) {
 		if ((base = builtin_typename(sym->ctype.base_type)) == NULL) {
 			if (!sym->ctype.base_type->aux) {
-				examine_symbol(sym->ctype.base_type, root_node);
+				examine_symbol(sym->ctype.base_type, NULL);
 			}
-			xmlNewProp(child, BAD_CAST "base-type",
-			           xmlGetProp((xmlNodePtr)sym->ctype.base_type->aux, BAD_CAST "id"));
+			buf[0] = '\0';
+			if (sym->ctype.base_type->aux)
+				snprintf(buf, sizeof(buf), "_%lu",
+					 (unsigned long)sym->ctype.base_type->aux - 1);
+			newProp(child, "base-type", buf);
 		} else {
 			newProp(child, "base-type-builtin", base);
 		}
@@ -215,7 +354,7 @@ static void examine_symbol(struct symbol *sym, xmlNodePtr node)
 		newProp(child, "base-type-builtin", builtin_typename(sym));
 		break;
 	}
-	return;
+	close_element(child);
 }
 
 static struct position *get_expansion_end (struct token *token)
@@ -232,8 +371,9 @@ static struct position *get_expansion_end (struct token *token)
 		return NULL;
 }
 
-static void examine_macro(struct symbol *sym, xmlNodePtr node)
+static void examine_macro(struct symbol *sym, struct element *node)
 {
+	struct element elem;
 	struct position *pos;
 
 	/* this should probably go in the main codebase*/
@@ -243,7 +383,9 @@ static void examine_macro(struct symbol *sym, xmlNodePtr node)
 	else
 		sym->endpos = sym->pos;
 
-	new_sym_node(sym, "macro", node);
+	open_element(&elem, node);
+	new_sym_node(sym, "macro", &elem);
+	close_element(&elem);
 }
 
 static void examine_namespace(struct symbol *sym)
@@ -253,12 +395,12 @@ static void examine_namespace(struct symbol *sym)
 
 	switch(sym->namespace) {
 	case NS_MACRO:
-		examine_macro(sym, root_node);
+		examine_macro(sym, NULL);
 		break;
 	case NS_TYPEDEF:
 	case NS_STRUCT:
 	case NS_SYMBOL:
-		examine_symbol(sym, root_node);
+		examine_symbol(sym, NULL);
 		break;
 	case NS_NONE:
 	case NS_LABEL:
@@ -302,9 +444,7 @@ int main(int argc, char **argv)
 	struct symbol_list *symlist = NULL;
 	char *file;
 
-	doc = xmlNewDoc(BAD_CAST "1.0");
-	root_node = xmlNewNode(NULL, BAD_CAST "parse");
-	xmlDocSetRootElement(doc, root_node);
+	fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<parse", stdout);
 
 /* - A DTD is probably unnecessary for something like this
 
@@ -323,11 +463,10 @@ int main(int argc, char **argv)
 		examine_symbol_list(file, global_scope->symbols);
 	} END_FOR_EACH_PTR_NOTAG(file);
 
-
-	xmlSaveFormatFileEnc("-", doc, "UTF-8", 1);
-	xmlFreeDoc(doc);
-	xmlCleanupParser();
+	if (root_has_children)
+		fputs("</parse>\n", stdout);
+	else
+		fputs("/>\n", stdout);
 
 	return 0;
 }
-
@@ -288,6 +288,8 @@ void check_implicit_dependencies(int id)
 
     if (option_project != PROJ_KERNEL)
 	return;
+    /* parsed_syscalls is kept for the whole file */
+    run_functions_serially();
 
     add_hook(&match_syscall_definition, AFTER_DEF_HOOK);
     add_hook(&match_after_syscall, AFTER_FUNC_HOOK);
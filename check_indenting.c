@@ -67,7 +67,7 @@ static int missing_curly_braces(struct statement *stmt)
 
 static int prev_lines_say_endif(struct statement *stmt)
 {
-	struct token *token;
+	struct ident *ident;
 	struct position pos = stmt->pos;
 	int i;
 
@@ -75,9 +75,8 @@ static int prev_lines_say_endif(struct statement *stmt)
 
 	for (i = 0; i < 4; i++) {
 		pos.line--;
-		token = pos_get_token(pos);
-		if (token && token_type(token) == TOKEN_IDENT &&
-		    strcmp(show_ident(token->ident), "endif") == 0)
+		ident = pos_get_ident(pos);
+		if (ident && strcmp(show_ident(ident), "endif") == 0)
 			return 1;
 	}
 
@@ -202,6 +201,8 @@ static void match_end_func(void)
 	if (__inline_fn)
 		return;
 	orig_pos = 0;
+	memset(&ignore_prev, 0, sizeof(ignore_prev));
+	memset(&ignore_prev_inline, 0, sizeof(ignore_prev_inline));
 }
 
 static void register_ignored_macros(void)
@@ -224,14 +224,15 @@ static void find_module_init_exit(struct symbol_list *sym_list)
 			continue;
 		if (!sym->ident)
 			continue;
-		if (!fn->inline_stmt)
-			continue;
 		if (strcmp(sym->ident->name, "__inittest") == 0)
 			init = 1;
 		else if (strcmp(sym->ident->name, "__exittest") == 0)
 			init = 0;
 		else
 			continue;
+		parse_lazy_body(sym);
+		if (!fn->inline_stmt)
+			continue;
 
 		count++;
 
@@ -129,6 +129,13 @@ static void match_stmt(struct statement *stmt)
 		old_pos.line = 0;
 }
 
+static void match_end_func(struct symbol *sym)
+{
+	if (__inline_fn)
+		return;
+	old_pos.line = 0;
+}
+
 static void register_ignored_macros(void)
 {
 	struct token *token;
@@ -162,5 +169,6 @@ void check_macro_side_effects(int id)
 
 	add_hook(&match_unop, OP_HOOK);
 	add_hook(&match_stmt, STMT_HOOK);
+	add_hook(&match_end_func, END_FUNC_HOOK);
 	register_ignored_macros();
 }
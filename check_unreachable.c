@@ -80,21 +80,19 @@ static int is_ignored_macro(struct statement *stmt)
 
 static int prev_line_was_endif(struct statement *stmt)
 {
-	struct token *token;
+	struct ident *ident;
 	struct position pos = stmt->pos;
 
 	pos.line--;
 	pos.pos = 2;
 
-	token = pos_get_token(pos);
-	if (token && token_type(token) == TOKEN_IDENT &&
-	    strcmp(show_ident(token->ident), "endif") == 0)
+	ident = pos_get_ident(pos);
+	if (ident && strcmp(show_ident(ident), "endif") == 0)
 		return 1;
 
 	pos.line--;
-	token = pos_get_token(pos);
-	if (token && token_type(token) == TOKEN_IDENT &&
-	    strcmp(show_ident(token->ident), "endif") == 0)
+	ident = pos_get_ident(pos);
+	if (ident && strcmp(show_ident(ident), "endif") == 0)
 		return 1;
 
 	return 0;
@@ -79,8 +79,10 @@ DECLARE_PTR_LIST(storage_list, struct storage);
 
 struct function {
 	int stack_size;
+	int pushed;		/* bytes pushed for a call being set up */
 	int pseudo_nr;
 	struct storage_list *pseudo_list;
+	struct symbol_list *sym_list;	/* symbols given storage on the stack */
 	struct atom_list *atom_list;
 	struct str_list *str_list;
 	struct loop_stack *loop_stack;
@@ -147,6 +149,7 @@ struct storage {
 enum {
 	STOR_LABEL_VAL	= (1 << 0),
 	STOR_WANTS_FREE	= (1 << 1),
+	STOR_VARIABLE	= (1 << 2),	/* a local variable, not a temporary */
 };
 
 struct symbol_private {
@@ -166,6 +169,8 @@ struct atom {
 		struct {
 			char *text;
 			unsigned int text_len;  /* w/o terminating null */
+			int text_label;		/* the text is this label */
+			struct symbol *text_labelsym;
 		};
 
 		/* stuff for insns */
@@ -174,6 +179,7 @@ struct atom {
 			char comment[40];
 			struct storage *op1;
 			struct storage *op2;
+			int pushed;
 		};
 
 		/* stuff for C strings */
@@ -383,6 +389,18 @@ static struct storage *get_reg_value(struct storage *value, struct regclass *cla
 	return reg;
 }
 
+/*
+ * Forget what the registers are caching.  At a jump target the registers
+ * might have come from somewhere else and a call clobbers them.
+ */
+static void forget_reg_values(void)
+{
+	int regno;
+
+	for (regno = AL; regno <= ESI_EDI; regno++)
+		reg_info_table[regno].contains = NULL;
+}
+
 static struct storage *temp_from_bits(unsigned int bit_size)
 {
 	return get_reg(get_regclass_bits(bit_size));
@@ -433,16 +451,19 @@ static void stor_sym_init(struct symbol *sym)
 	stor->sym = sym;
 }
 
+/* %esp moves while the arguments for a call are pushed */
+static int stack_pushed;
+
 static const char *stor_op_name(struct storage *s)
 {
 	static char name[32];
 
 	switch (s->type) {
 	case STOR_PSEUDO:
-		strcpy(name, pretty_offset((int) pseudo_offset(s)));
+		strcpy(name, pretty_offset((int) pseudo_offset(s) + stack_pushed));
 		break;
 	case STOR_ARG:
-		strcpy(name, pretty_offset((int) arg_offset(s)));
+		strcpy(name, pretty_offset((int) arg_offset(s) + stack_pushed));
 		break;
 	case STOR_SYM:
 		strcpy(name, show_ident(s->sym->ident));
@@ -496,7 +517,7 @@ static inline void push_atom(struct function *f, struct atom *atom)
 	add_ptr_list(&f->atom_list, atom);
 }
 
-static void push_text_atom(struct function *f, const char *text)
+static struct atom *push_text_atom(struct function *f, const char *text)
 {
 	struct atom *atom = new_atom(ATOM_TEXT);
 
@@ -504,6 +525,7 @@ static void push_text_atom(struct function *f, const char *text)
 	atom->text_len = strlen(text);
 
 	push_atom(f, atom);
+	return atom;
 }
 
 static struct storage *new_storage(enum storage_type type)
@@ -638,6 +660,7 @@ static void insn(const char *insn, struct storage *op1, struct storage *op2,
 
 	atom->op1 = op1;
 	atom->op2 = op2;
+	atom->pushed = f->pushed;
 
 	push_atom(f, atom);
 }
@@ -667,7 +690,8 @@ static void emit_label (int label, const char *comment)
 	else
 		sprintf(s, ".L%d:\t\t\t\t\t# %s\n", label, comment);
 
-	push_text_atom(f, s);
+	push_text_atom(f, s)->text_label = label;
+	forget_reg_values();
 }
 
 static void emit_labelsym (struct symbol *sym, const char *comment)
@@ -680,7 +704,8 @@ static void emit_labelsym (struct symbol *sym, const char *comment)
 	else
 		sprintf(s, ".LS%p:\t\t\t\t# %s\n", sym, comment);
 
-	push_text_atom(f, s);
+	push_text_atom(f, s)->text_labelsym = sym;
+	forget_reg_values();
 }
 
 void emit_unit_begin(const char *basename)
@@ -718,6 +743,8 @@ static void emit_insn_atom(struct function *f, struct atom *atom)
 	else
 		comment[0] = 0;
 
+	stack_pushed = atom->pushed;
+
 	if (atom->op2) {
 		char tmp[16];
 		strcpy(tmp, stor_op_name(op1));
@@ -775,6 +802,7 @@ static void emit_string_list(struct function *f)
 static void func_cleanup(struct function *f)
 {
 	struct storage *stor;
+	struct symbol *sym;
 	struct atom *atom;
 
 	FOR_EACH_PTR(f->atom_list, atom) {
@@ -792,9 +820,360 @@ static void func_cleanup(struct function *f)
 	} END_FOR_EACH_PTR(stor);
 
 	free_ptr_list(&f->pseudo_list);
+
+	/* the storage is gone, don't let the next function find it */
+	FOR_EACH_PTR(f->sym_list, sym) {
+		free(sym->aux);
+		sym->aux = NULL;
+	} END_FOR_EACH_PTR(sym);
+	free_ptr_list(&f->sym_list);
 	free(f);
 }
 
+/*
+ * Every expression leaves its result in a new stack slot and only a few
+ * scratch registers are ever used, so the code is mostly loads and stores.
+ * Once a function is generated do a linear scan over its atoms and move the
+ * 32-bit pseudos into the callee saved registers which the function doesn't
+ * otherwise touch.  A pseudo lives from its first to its last reference,
+ * stretched over any loop it is live around.  When there are more pseudos
+ * than registers the ones with the fewest uses, weighted by loop depth, stay
+ * on the stack.  -fno-regalloc turns it off.
+ */
+
+struct live_interval {
+	int start, end;
+	unsigned int cost;
+	int refs, writes;
+	int temporary;
+	int regno;		/* or one of the below */
+};
+
+#define LIVE_STACK	-1	/* stays on the stack */
+#define LIVE_NO_REG	-2	/* can't be put in a register */
+#define LIVE_DEAD	-3	/* written but never read */
+
+struct loop_range {
+	int start, end;
+};
+
+static const unsigned char callee_saved[] = { EBX, ESI, EDI, EBP };
+
+#define REG_BIT(regno) (1 << ((regno) - EAX))
+
+/* the 32-bit registers which overlap regno */
+static unsigned int reg32_mask(int regno)
+{
+	const unsigned char *aliases = reg_info_table[regno].aliases;
+	unsigned int mask = 0;
+
+	while ((regno = *aliases++) != NOREG) {
+		if (regno >= EAX && regno <= ESP)
+			mask |= REG_BIT(regno);
+	}
+	return mask;
+}
+
+static unsigned int atom_reg_mask(struct atom *atom)
+{
+	unsigned int mask = 0;
+	int regno;
+
+	if (atom->type == ATOM_TEXT) {
+		/* labels and comments, or hand written instructions */
+		if (atom->text_label || atom->text_labelsym)
+			return 0;
+		if (!strncmp(atom->text, "\t#", 2) || !strchr(atom->text, '%'))
+			return 0;
+		for (regno = AL; regno <= ESP; regno++) {
+			if (strstr(atom->text, reg_info_table[regno].name))
+				mask |= reg32_mask(regno);
+		}
+		return mask;
+	}
+
+	if (atom->op1 && atom->op1->type == STOR_REG)
+		mask |= reg32_mask(atom->op1->reg->own_regno);
+	if (atom->op2 && atom->op2->type == STOR_REG)
+		mask |= reg32_mask(atom->op2->reg->own_regno);
+	if (!strncmp(atom->insn, "div", 3) || !strncmp(atom->insn, "idiv", 4) ||
+	    !strncmp(atom->insn, "mul", 3))
+		mask |= REG_BIT(EAX) | REG_BIT(EDX);
+	return mask;
+}
+
+/* Only full 32-bit accesses can be turned into register accesses */
+static int pseudo_insn_ok(const char *insn)
+{
+	return insn[strlen(insn) - 1] == 'l' || !strcmp(insn, "mov");
+}
+
+static int insn_writes(struct atom *atom, struct storage *op)
+{
+	if (atom->op2)
+		return op == atom->op2 && strncmp(atom->insn, "cmp", 3) &&
+		       strcmp(atom->insn, "test");
+	/* inc, dec, neg and not */
+	return op == atom->op1 && strncmp(atom->insn, "push", 4);
+}
+
+static int find_label_pos(struct atom **atoms, int nr, struct storage *target)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (atoms[i]->type != ATOM_TEXT)
+			continue;
+		if (target->type == STOR_LABEL &&
+		    atoms[i]->text_label == target->label)
+			return i;
+		if (target->type == STOR_LABELSYM &&
+		    atoms[i]->text_labelsym == target->labelsym)
+			return i;
+	}
+	return -1;
+}
+
+static void note_pseudo(struct live_interval *live, struct atom *atom,
+			struct storage *op, int pos, unsigned int weight)
+{
+	struct live_interval *l;
+
+	if (!op || op->type != STOR_PSEUDO)
+		return;
+
+	l = &live[op->pseudo];
+	if (l->start < 0) {
+		l->start = pos;
+		/* defined once before any use: not live around loops */
+		l->temporary = !(op->flags & STOR_VARIABLE) &&
+			       !strncmp(atom->insn, "mov", 3) && op == atom->op2;
+	}
+	l->end = pos;
+	l->cost += weight;
+	l->refs++;
+	if (insn_writes(atom, op))
+		l->writes++;
+	if (op->size != 4 || !pseudo_insn_ok(atom->insn))
+		l->regno = LIVE_NO_REG;
+}
+
+static int compare_intervals(const void *_a, const void *_b)
+{
+	const struct live_interval *a = *(struct live_interval **)_a;
+	const struct live_interval *b = *(struct live_interval **)_b;
+
+	if (a->start != b->start)
+		return a->start < b->start ? -1 : 1;
+	return a < b ? -1 : a > b;
+}
+
+/*
+ * Returns the callee saved registers which the function uses, so that the
+ * prologue can save them.
+ */
+static unsigned int allocate_registers(struct function *f)
+{
+	struct live_interval *live, **sorted;
+	struct live_interval *active[ARRAY_SIZE(callee_saved)];
+	struct loop_range *loops;
+	struct storage *stor;
+	struct atom **atoms, *atom;
+	unsigned int used = 0, saved = 0, weight;
+	int nr, nr_loops = 0, nr_sorted = 0, nr_active = 0;
+	int *depth;
+	int i, j, changed, offset;
+
+	nr = ptr_list_size((struct ptr_list *)f->atom_list);
+	atoms = calloc(nr + 1, sizeof(*atoms));
+	depth = calloc(nr + 1, sizeof(*depth));
+	loops = calloc(nr + 1, sizeof(*loops));
+	live = calloc(f->pseudo_nr + 1, sizeof(*live));
+	sorted = calloc(f->pseudo_nr + 1, sizeof(*sorted));
+	if (!atoms || !depth || !loops || !live || !sorted)
+		die("OOM in allocate_registers");
+
+	i = 0;
+	FOR_EACH_PTR(f->atom_list, atom) {
+		atoms[i++] = atom;
+		used |= atom_reg_mask(atom);
+	} END_FOR_EACH_PTR(atom);
+
+	/* a backwards jump closes a loop */
+	for (i = 0; i < nr; i++) {
+		atom = atoms[i];
+		if (atom->type != ATOM_INSN || atom->insn[0] != 'j' || !atom->op1)
+			continue;
+		if (atom->op1->type != STOR_LABEL && atom->op1->type != STOR_LABELSYM)
+			continue;
+		j = find_label_pos(atoms, nr, atom->op1);
+		if (j < 0 || j > i)
+			continue;
+		loops[nr_loops].start = j;
+		loops[nr_loops].end = i;
+		nr_loops++;
+		depth[j]++;
+		depth[i + 1]--;
+	}
+	for (i = 1; i < nr; i++)
+		depth[i] += depth[i - 1];
+
+	for (i = 0; i < f->pseudo_nr; i++) {
+		live[i].start = -1;
+		live[i].regno = LIVE_STACK;
+	}
+	for (i = 0; i < nr; i++) {
+		atom = atoms[i];
+		if (atom->type != ATOM_INSN)
+			continue;
+		weight = 1 << (3 * (depth[i] < 4 ? depth[i] : 4));
+		note_pseudo(live, atom, atom->op1, i, weight);
+		note_pseudo(live, atom, atom->op2, i, weight);
+	}
+
+	for (i = 0; i < f->pseudo_nr; i++) {
+		struct live_interval *l = &live[i];
+
+		if (l->start < 0 || l->regno == LIVE_NO_REG)
+			continue;
+		/* the result of an expression which is never used */
+		if (l->temporary && l->refs == 1) {
+			l->regno = LIVE_DEAD;
+			continue;
+		}
+		if (!l->temporary || l->writes != 1) {
+			do {
+				changed = 0;
+				for (j = 0; j < nr_loops; j++) {
+					if (l->start > loops[j].end || l->end < loops[j].start)
+						continue;
+					if (l->start > loops[j].start) {
+						l->start = loops[j].start;
+						changed = 1;
+					}
+					if (l->end < loops[j].end) {
+						l->end = loops[j].end;
+						changed = 1;
+					}
+				}
+			} while (changed);
+		}
+		sorted[nr_sorted++] = l;
+	}
+	qsort(sorted, nr_sorted, sizeof(*sorted), compare_intervals);
+
+	for (i = 0; i < nr_sorted; i++) {
+		struct live_interval *cur = sorted[i];
+		unsigned int free_regs = 0;
+		int victim = -1;
+
+		/* expire the intervals which ended */
+		for (j = 0; j < nr_active; j++) {
+			if (active[j]->end < cur->start)
+				active[j--] = active[--nr_active];
+		}
+
+		for (j = 0; j < ARRAY_SIZE(callee_saved); j++)
+			free_regs |= REG_BIT(callee_saved[j]);
+		free_regs &= ~used;
+		for (j = 0; j < nr_active; j++)
+			free_regs &= ~REG_BIT(active[j]->regno);
+
+		for (j = 0; j < ARRAY_SIZE(callee_saved); j++) {
+			if (free_regs & REG_BIT(callee_saved[j])) {
+				cur->regno = callee_saved[j];
+				break;
+			}
+		}
+		if (cur->regno >= 0) {
+			active[nr_active++] = cur;
+			continue;
+		}
+
+		/* no register left, the cheapest interval goes to the stack */
+		for (j = 0; j < nr_active; j++) {
+			if (active[j]->cost >= cur->cost)
+				continue;
+			if (victim < 0 || active[j]->cost < active[victim]->cost)
+				victim = j;
+		}
+		if (victim < 0)
+			continue;
+		cur->regno = active[victim]->regno;
+		active[victim]->regno = LIVE_STACK;
+		active[victim] = cur;
+	}
+
+	/* a register which has to be saved must be worth more than the save */
+	for (i = 0; i < ARRAY_SIZE(callee_saved); i++) {
+		unsigned int cost = 0;
+
+		if (used & REG_BIT(callee_saved[i]))
+			continue;
+		for (j = 0; j < nr_sorted; j++) {
+			if (sorted[j]->regno == callee_saved[i])
+				cost += sorted[j]->cost;
+		}
+		if (cost > 2)
+			continue;
+		for (j = 0; j < nr_sorted; j++) {
+			if (sorted[j]->regno == callee_saved[i])
+				sorted[j]->regno = LIVE_STACK;
+		}
+	}
+
+	FOR_EACH_PTR(f->atom_list, atom) {
+		struct live_interval *l;
+
+		if (atom->type != ATOM_INSN)
+			continue;
+		if (atom->op2 && atom->op2->type == STOR_PSEUDO) {
+			l = &live[atom->op2->pseudo];
+			if (l->regno == LIVE_DEAD) {
+				DELETE_CURRENT_PTR(atom);
+				free(atom);
+				continue;
+			}
+		}
+		if (atom->op1 && atom->op1->type == STOR_PSEUDO &&
+		    live[atom->op1->pseudo].regno >= 0)
+			atom->op1 = hardreg_storage_table + live[atom->op1->pseudo].regno;
+		if (atom->op2 && atom->op2->type == STOR_PSEUDO &&
+		    live[atom->op2->pseudo].regno >= 0)
+			atom->op2 = hardreg_storage_table + live[atom->op2->pseudo].regno;
+		if (atom->op1 && atom->op1 == atom->op2 &&
+		    atom->op1->type == STOR_REG && !strncmp(atom->insn, "mov", 3)) {
+			DELETE_CURRENT_PTR(atom);
+			free(atom);
+		}
+	} END_FOR_EACH_PTR(atom);
+	PACK_PTR_LIST(&f->atom_list);
+
+	/* the pseudos which are left get packed together */
+	offset = 0;
+	FOR_EACH_PTR(f->pseudo_list, stor) {
+		if (live[stor->pseudo].regno == LIVE_DEAD)
+			continue;
+		if (live[stor->pseudo].regno >= 0) {
+			saved |= REG_BIT(live[stor->pseudo].regno);
+			continue;
+		}
+		stor->offset = offset;
+		offset += stor->size;
+	} END_FOR_EACH_PTR(stor);
+	f->stack_size = offset;
+
+	for (i = 0; i < ARRAY_SIZE(callee_saved); i++)
+		saved |= used & REG_BIT(callee_saved[i]);
+
+	free(atoms);
+	free(depth);
+	free(loops);
+	free(live);
+	free(sorted);
+	return saved;
+}
+
 /* function prologue */
 static void emit_func_pre(struct symbol *sym)
 {
@@ -849,7 +1228,17 @@ static void emit_func_post(struct symbol *sym)
 {
 	const char *name = show_ident(sym->ident);
 	struct function *f = current_func;
-	int stack_size = f->stack_size;
+	struct storage *save_slot[ARRAY_SIZE(callee_saved)];
+	unsigned int saved = 0;
+	int stack_size, i;
+
+	if (fregalloc)
+		saved = allocate_registers(f);
+	for (i = 0; i < ARRAY_SIZE(callee_saved); i++) {
+		if (saved & REG_BIT(callee_saved[i]))
+			save_slot[i] = stack_alloc(4);
+	}
+	stack_size = f->stack_size;
 
 	if (f->str_list)
 		emit_string_list(f);
@@ -867,12 +1256,23 @@ static void emit_func_post(struct symbol *sym)
 		sprintf(pseudo_const, "$%d", stack_size);
 		printf("\tsubl\t%s, %%esp\n", pseudo_const);
 	}
+	for (i = 0; i < ARRAY_SIZE(callee_saved); i++) {
+		if (saved & REG_BIT(callee_saved[i]))
+			printf("\tmovl\t%s, %s\n", reg_info_table[callee_saved[i]].name,
+			       pretty_offset(save_slot[i]->offset));
+	}
 
 	/* function epilogue */
 
 	/* jump target for 'return' statements */
 	emit_label(f->ret_target, NULL);
 
+	for (i = 0; i < ARRAY_SIZE(callee_saved); i++) {
+		if (saved & REG_BIT(callee_saved[i]))
+			insn("movl", save_slot[i],
+			     hardreg_storage_table + callee_saved[i], NULL);
+	}
+
 	if (stack_size) {
 		struct storage *val;
 
@@ -1332,6 +1732,10 @@ static struct storage *emit_divide(struct expression *expr, struct storage *left
 	insn("div", reg, REG_EAX, NULL);
 	put_reg(reg);
 
+	/* the div overwrote whatever EAX and EDX were caching */
+	REG_EAX->reg->contains = NULL;
+	REG_EDX->reg->contains = NULL;
+
 	reg = REG_EAX;
 	if (expr->op == '%')
 		reg = REG_EDX;
@@ -1403,8 +1807,8 @@ static struct storage *emit_binop(struct expression *expr)
 		break;
 	}
 
-	dest = get_reg_value(right, &regclass_32);
-	src = get_reg_value(left, &regclass_32);
+	dest = get_reg_value(left, &regclass_32);
+	src = get_reg_value(right, &regclass_32);
 	switch (expr->ctype->bit_size) {
 	case 8:
 		suffix = "b";
@@ -1620,6 +2024,8 @@ static struct storage *emit_symbol_expr_init(struct symbol *sym)
 	if (priv == NULL) {
 		priv = calloc(1, sizeof(*priv));
 		sym->aux = priv;
+		if (current_func)
+			add_symbol(&current_func->sym_list, sym);
 
 		if (expr == NULL) {
 			struct storage *new = stack_alloc(4);
@@ -1630,6 +2036,8 @@ static struct storage *emit_symbol_expr_init(struct symbol *sym)
 		} else {
 			priv->addr = x86_expression(expr);
 		}
+		if (priv->addr && priv->addr->type == STOR_PSEUDO)
+			priv->addr->flags |= STOR_VARIABLE;
 	}
 
 	return priv->addr;
@@ -2097,6 +2505,7 @@ static struct storage *x86_call_expression(struct expression *expr)
 		     !framesize ? "begin function call" : NULL);
 
 		framesize += bits_to_bytes(size);
+		f->pushed += bits_to_bytes(size);
 	} END_FOR_EACH_PTR_REVERSE(arg);
 
 	fn = expr->fn;
@@ -2122,6 +2531,7 @@ static struct storage *x86_call_expression(struct expression *expr)
 		strcpy(s, "\tcall\t*%eax\n");
 		push_text_atom(f, s);
 	}
+	forget_reg_values();
 
 	/* FIXME: pay attention to BITS_IN_POINTER */
 	if (framesize) {
@@ -2129,6 +2539,7 @@ static struct storage *x86_call_expression(struct expression *expr)
 		val->value = (long long) framesize;
 		val->flags = STOR_WANTS_FREE;
 		insn("addl", val, REG_ESP, NULL);
+		f->pushed -= framesize;
 	}
 
 	retval = stack_alloc(4);
@@ -2255,12 +2666,13 @@ static void x86_symbol_init(struct symbol *sym)
 		new = x86_expression(expr);
 	else
 		new = stack_alloc(sym->bit_size / 8);
+	if (new && new->type == STOR_PSEUDO)
+		new->flags |= STOR_VARIABLE;
 
 	if (!priv) {
 		priv = calloc(1, sizeof(*priv));
 		sym->aux = priv;
-		/* FIXME: leak! we don't free... */
-		/* (well, we don't free symbols either) */
+		add_symbol(&current_func->sym_list, sym);
 	}
 
 	priv->addr = new;
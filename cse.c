@@ -17,8 +17,17 @@
 #include "linearize.h"
 #include "flow.h"
 
-#define INSN_HASH_SIZE 256
-static struct instruction_list *insn_hash_table[INSN_HASH_SIZE];
+/*
+ * The hash table is sized for the function we're working on so the buckets
+ * stay short even for huge generated functions.  It's only ever grown and is
+ * reused for the following functions, which only use as much of it as they
+ * need.
+ */
+#define INSN_HASH_MIN_BITS 8
+#define INSN_HASH_MAX_BITS 20
+static struct instruction_list **insn_hash_table;
+static unsigned int insn_hash_alloc;
+static unsigned int insn_hash_bits;
 
 int repeat_phase;
 
@@ -119,10 +128,33 @@ static void clean_up_one_instruction(struct basic_block *bb, struct instruction
 		return;
 	}
 	hash += hash >> 16;
-	hash &= INSN_HASH_SIZE-1;
+	hash = (unsigned int)(hash * 0x9e3779b9U) >> (32 - insn_hash_bits);
 	add_instruction(insn_hash_table + hash, insn);
 }
 
+static void size_insn_hash(struct entrypoint *ep)
+{
+	struct basic_block *bb;
+	unsigned long nr = 0;
+	unsigned int bits = INSN_HASH_MIN_BITS;
+
+	FOR_EACH_PTR(ep->bbs, bb) {
+		nr += instruction_list_size(bb->insns);
+	} END_FOR_EACH_PTR(bb);
+
+	while (bits < INSN_HASH_MAX_BITS && (1UL << bits) < nr)
+		bits++;
+	insn_hash_bits = bits;
+	if ((1U << bits) <= insn_hash_alloc)
+		return;
+
+	free(insn_hash_table);
+	insn_hash_alloc = 1U << bits;
+	insn_hash_table = calloc(insn_hash_alloc, sizeof(*insn_hash_table));
+	if (!insn_hash_table)
+		die("out of memory");
+}
+
 static void clean_up_insns(struct entrypoint *ep)
 {
 	struct basic_block *bb;
@@ -363,13 +395,14 @@ static struct instruction * try_to_cse(struct entrypoint *ep, struct instruction
 
 void cleanup_and_cse(struct entrypoint *ep)
 {
-	int i;
+	unsigned int i;
 
 	simplify_memops(ep);
+	size_insn_hash(ep);
 repeat:
 	repeat_phase = 0;
 	clean_up_insns(ep);
-	for (i = 0; i < INSN_HASH_SIZE; i++) {
+	for (i = 0; i < (1U << insn_hash_bits); i++) {
 		struct instruction_list **list = insn_hash_table + i;
 		if (*list) {
 			if (instruction_list_size(*list) > 1) {
@@ -248,7 +248,11 @@ int Wvla = 1;
 int dbg_entry = 0;
 int dbg_dead = 0;
 
+int fregalloc = 1;
+
 int preprocess_only;
+int preprocess_bench;
+unsigned long long preprocessed_tokens;
 
 static enum { STANDARD_C89,
               STANDARD_C94,
@@ -605,6 +609,22 @@ static char **handle_switch_ftabstop(char *arg, char **next)
 	return next;
 }
 
+static char **handle_switch_fpass_limit(char *arg, char **next)
+{
+	char *end;
+	unsigned long val;
+
+	if (*arg == '\0')
+		die("error: missing argument to \"-fpass-limit=\"");
+
+	val = strtoul(arg, &end, 10);
+	if (*end != '\0')
+		die("error: bad argument to \"-fpass-limit=\"");
+	fpass_limit = val;
+
+	return next;
+}
+
 static int funsigned_char;
 static void handle_funsigned_char(void)
 {
@@ -616,11 +636,16 @@ static void handle_funsigned_char(void)
 
 static char **handle_switch_f(char *arg, char **next)
 {
+	int flag = 1;
+
 	arg++;
 
 	if (!strncmp(arg, "tabstop=", 8))
 		return handle_switch_ftabstop(arg+8, next);
 
+	if (!strncmp(arg, "pass-limit=", 11))
+		return handle_switch_fpass_limit(arg+11, next);
+
 	if (!strcmp(arg, "unsigned-char")) {
 		funsigned_char = 1;
 		return next;
@@ -630,8 +655,15 @@ static char **handle_switch_f(char *arg, char **next)
 
 	if (!strncmp(arg, "no-", 3)) {
 		arg += 3;
+		flag = 0;
 	}
 	/* handle switch here.. */
+	if (!strcmp(arg, "macro-cache"))
+		fmacro_cache = flag;
+	if (!strcmp(arg, "regalloc"))
+		fregalloc = flag;
+	if (!strcmp(arg, "dump-pass-stats"))
+		fdump_pass_stats = flag;
 	return next;
 }
 
@@ -993,12 +1025,21 @@ void create_builtin_stream(void)
 	add_pre_buffer("#weak_define __CHAR_BIT__ " STRINGIFY(__CHAR_BIT__) "\n");
 }
 
+struct token *preprocessed_stream;
+int sparse_init_without_files;
+
 static struct symbol_list *sparse_tokenstream(struct token *token)
 {
 	// Preprocess the stream
 	token = preprocess(token);
+	preprocessed_stream = token;
 
 	if (preprocess_only) {
+		if (preprocess_bench) {
+			for (; !eof_token(token); token = token->next)
+				preprocessed_tokens++;
+			return NULL;
+		}
 		while (!eof_token(token)) {
 			int prec = 1;
 			struct token *next = token->next;
@@ -1025,10 +1066,21 @@ static struct symbol_list *sparse_tokenstream(struct token *token)
 	return translation_unit_used_list;
 }
 
+static struct symbol_list *sparse_fd(const char *filename, int fd)
+{
+	struct token *token;
+
+	// Tokenize the input stream
+	token = tokenize(filename, fd, NULL, includepath);
+	store_all_tokens(token);
+	close(fd);
+
+	return sparse_tokenstream(token);
+}
+
 static struct symbol_list *sparse_file(const char *filename)
 {
 	int fd;
-	struct token *token;
 
 	if (strcmp (filename, "-") == 0) {
 		fd = 0;
@@ -1038,12 +1090,7 @@ static struct symbol_list *sparse_file(const char *filename)
 			die("No such file: %s", filename);
 	}
 
-	// Tokenize the input stream
-	token = tokenize(filename, fd, NULL, includepath);
-	store_all_tokens(token);
-	close(fd);
-
-	return sparse_tokenstream(token);
+	return sparse_fd(filename, fd);
 }
 
 /*
@@ -1094,7 +1141,7 @@ struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list
 	handle_arch_finalize();
 
 	list = NULL;
-	if (!ptr_list_empty(filelist)) {
+	if (!ptr_list_empty(filelist) || sparse_init_without_files) {
 		// Initialize type system
 		init_ctype();
 		handle_funsigned_char();
@@ -1129,6 +1176,15 @@ struct symbol_list * sparse_keep_tokens(char *filename)
 	return res;
 }
 
+/* Same as sparse_keep_tokens() but the source is read from fd */
+struct symbol_list * sparse_keep_tokens_fd(char *filename, int fd)
+{
+	translation_unit_used_list = NULL;
+
+	new_file_scope();
+	return sparse_fd(filename, fd);
+}
+
 
 struct symbol_list * __sparse(char *filename)
 {
@@ -102,6 +102,12 @@ extern void expression_error(struct expression *, const char *, ...) FORMAT_ATTR
 extern void add_pre_buffer(const char *fmt, ...) FORMAT_ATTR(1);
 
 extern int preprocess_only;
+extern int preprocess_bench;
+extern unsigned long long preprocessed_tokens;
+extern int fmacro_cache;
+extern int fregalloc;
+extern int fdump_pass_stats;
+extern int fpass_limit;
 
 extern int Waddress_space;
 extern int Wbitwise;
@@ -141,6 +147,11 @@ extern void create_builtin_stream(void);
 extern struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list **files);
 extern struct symbol_list *__sparse(char *filename);
 extern struct symbol_list *sparse_keep_tokens(char *filename);
+extern struct symbol_list *sparse_keep_tokens_fd(char *filename, int fd);
+/* the start of the last preprocessed stream, only useful with sparse_keep_tokens() */
+extern struct token *preprocessed_stream;
+/* set up the types and builtins even if no files are given */
+extern int sparse_init_without_files;
 extern struct symbol_list *sparse(char *filename);
 
 static inline int symbol_list_size(struct symbol_list *list)
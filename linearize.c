@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <sys/time.h>
 
 #include "parse.h"
 #include "expression.h"
@@ -2117,76 +2118,155 @@ pseudo_t linearize_statement(struct entrypoint *ep, struct statement *stmt)
 	return VOID;
 }
 
-static struct entrypoint *linearize_fn(struct symbol *sym, struct symbol *base_type)
+/*
+ * The passes which clean up a freshly linearized function.  With
+ * -fdump-pass-stats the number of times each one ran, the time it took and
+ * the instruction count before and after are printed to stderr as
+ *
+ *	pass_stats: function|name|cse_rounds|flow_rounds|converged
+ *	pass_stats: pass|function|pass|runs|usecs|insns_before|insns_after
+ *
+ * -fpass-limit=<n> stops repeating the passes after <n> rounds.
+ */
+int fdump_pass_stats;
+int fpass_limit;
+
+struct pass {
+	const char *name;
+	int (*run)(struct entrypoint *ep);
+	int runs;
+	unsigned long long usecs;
+	int insns_before, insns_after;
+};
+
+#define VOID_PASS(fn)						\
+static int do_##fn(struct entrypoint *ep)			\
+{								\
+	fn(ep);							\
+	return 0;						\
+}
+
+VOID_PASS(kill_unreachable_bbs)
+VOID_PASS(simplify_symbol_usage)
+VOID_PASS(cleanup_and_cse)
+VOID_PASS(pack_basic_blocks)
+VOID_PASS(vrfy_flow)
+VOID_PASS(clear_symbol_pseudos)
+VOID_PASS(track_pseudo_liveness)
+VOID_PASS(clear_liveness)
+VOID_PASS(track_pseudo_death)
+
+static struct pass pass_unreachable = { "unreachable", do_kill_unreachable_bbs };
+static struct pass pass_symbols = { "symbols", do_simplify_symbol_usage };
+static struct pass pass_cse = { "cse", do_cleanup_and_cse };
+static struct pass pass_pack = { "pack", do_pack_basic_blocks };
+static struct pass pass_vrfy = { "vrfy", do_vrfy_flow };
+static struct pass pass_clear_symbols = { "clear_symbols", do_clear_symbol_pseudos };
+static struct pass pass_liveness = { "liveness", do_track_pseudo_liveness };
+static struct pass pass_flow = { "flow", simplify_flow };
+static struct pass pass_clear_liveness = { "clear_liveness", do_clear_liveness };
+static struct pass pass_death = { "death", do_track_pseudo_death };
+
+static struct pass *all_passes[] = {
+	&pass_unreachable, &pass_symbols, &pass_cse, &pass_pack, &pass_vrfy,
+	&pass_clear_symbols, &pass_liveness, &pass_flow, &pass_clear_liveness,
+	&pass_death,
+};
+
+static int count_insns(struct entrypoint *ep)
 {
-	struct entrypoint *ep;
 	struct basic_block *bb;
-	struct symbol *arg;
-	struct instruction *entry;
-	pseudo_t result;
-	int i;
-
-	if (!base_type->stmt)
-		return NULL;
+	struct instruction *insn;
+	int nr = 0;
 
-	ep = alloc_entrypoint();
-	bb = alloc_basic_block(ep, sym->pos);
-	
-	ep->name = sym;
-	sym->ep = ep;
-	set_activeblock(ep, bb);
+	FOR_EACH_PTR(ep->bbs, bb) {
+		FOR_EACH_PTR(bb->insns, insn) {
+			if (insn->bb)
+				nr++;
+		} END_FOR_EACH_PTR(insn);
+	} END_FOR_EACH_PTR(bb);
+	return nr;
+}
 
-	entry = alloc_instruction(OP_ENTRY, 0);
-	add_one_insn(ep, entry);
-	ep->entry = entry;
+static int run_pass(struct entrypoint *ep, struct pass *pass)
+{
+	struct timeval start, stop;
+	int ret;
 
-	concat_symbol_list(base_type->arguments, &ep->syms);
+	if (!fdump_pass_stats)
+		return pass->run(ep);
 
-	/* FIXME!! We should do something else about varargs.. */
-	i = 0;
-	FOR_EACH_PTR(base_type->arguments, arg) {
-		linearize_argument(ep, arg, ++i);
-	} END_FOR_EACH_PTR(arg);
+	if (!pass->runs++)
+		pass->insns_before = count_insns(ep);
+	gettimeofday(&start, NULL);
+	ret = pass->run(ep);
+	gettimeofday(&stop, NULL);
+	pass->usecs += (stop.tv_sec - start.tv_sec) * 1000000ULL +
+		       stop.tv_usec - start.tv_usec;
+	pass->insns_after = count_insns(ep);
+	return ret;
+}
 
-	result = linearize_statement(ep, base_type->stmt);
-	if (bb_reachable(ep->active) && !bb_terminated(ep->active)) {
-		struct symbol *ret_type = base_type->ctype.base_type;
-		struct instruction *insn = alloc_typed_instruction(OP_RET, ret_type);
+static void show_pass_stats(struct entrypoint *ep, int cse_rounds, int flow_rounds, int converged)
+{
+	const char *name = show_ident(ep->name->ident);
+	struct pass *pass;
+	int i;
 
-		if (type_size(ret_type) > 0)
-			use_pseudo(insn, result, &insn->src);
-		add_one_insn(ep, insn);
+	fprintf(stderr, "pass_stats: function|%s|%d|%d|%d\n", name,
+		cse_rounds, flow_rounds, converged);
+	for (i = 0; i < ARRAY_SIZE(all_passes); i++) {
+		pass = all_passes[i];
+		if (pass->runs)
+			fprintf(stderr, "pass_stats: pass|%s|%s|%d|%llu|%d|%d\n",
+				name, pass->name, pass->runs, pass->usecs,
+				pass->insns_before, pass->insns_after);
+		pass->runs = 0;
+		pass->usecs = 0;
 	}
+}
+
+static void run_passes(struct entrypoint *ep)
+{
+	int cse_rounds = 0, flow_rounds = 0;
+	int converged = 1;
 
 	/*
 	 * Do trivial flow simplification - branches to
 	 * branches, kill dead basicblocks etc
 	 */
-	kill_unreachable_bbs(ep);
+	run_pass(ep, &pass_unreachable);
 
 	/*
 	 * Turn symbols into pseudos
 	 */
-	simplify_symbol_usage(ep);
+	run_pass(ep, &pass_symbols);
 
 repeat:
+	flow_rounds++;
 	/*
 	 * Remove trivial instructions, and try to CSE
 	 * the rest.
 	 */
 	do {
-		cleanup_and_cse(ep);
-		pack_basic_blocks(ep);
+		run_pass(ep, &pass_cse);
+		run_pass(ep, &pass_pack);
+		cse_rounds++;
+		if (fpass_limit && cse_rounds >= fpass_limit &&
+		    (repeat_phase & REPEAT_CSE)) {
+			converged = 0;
+			break;
+		}
 	} while (repeat_phase & REPEAT_CSE);
 
-	kill_unreachable_bbs(ep);
-	vrfy_flow(ep);
+	run_pass(ep, &pass_unreachable);
+	run_pass(ep, &pass_vrfy);
 
 	/* Cleanup */
-	clear_symbol_pseudos(ep);
+	run_pass(ep, &pass_clear_symbols);
 
 	/* And track pseudo register usage */
-	track_pseudo_liveness(ep);
+	run_pass(ep, &pass_liveness);
 
 	/*
 	 * Some flow optimizations can only effectively
@@ -2194,15 +2274,64 @@ repeat:
 	 * if they trigger, we need to start all over
 	 * again
 	 */
-	if (simplify_flow(ep)) {
-		clear_liveness(ep);
-		goto repeat;
+	if (run_pass(ep, &pass_flow)) {
+		run_pass(ep, &pass_clear_liveness);
+		if (converged && (!fpass_limit || flow_rounds < fpass_limit))
+			goto repeat;
+		converged = 0;
+		run_pass(ep, &pass_liveness);
 	}
 
 	/* Finally, add deathnotes to pseudos now that we have them */
 	if (dbg_dead)
-		track_pseudo_death(ep);
+		run_pass(ep, &pass_death);
+
+	if (fdump_pass_stats)
+		show_pass_stats(ep, cse_rounds, flow_rounds, converged);
+}
+
+static struct entrypoint *linearize_fn(struct symbol *sym, struct symbol *base_type)
+{
+	struct entrypoint *ep;
+	struct basic_block *bb;
+	struct symbol *arg;
+	struct instruction *entry;
+	pseudo_t result;
+	int i;
+
+	if (!base_type->stmt)
+		return NULL;
+
+	ep = alloc_entrypoint();
+	bb = alloc_basic_block(ep, sym->pos);
+	
+	ep->name = sym;
+	sym->ep = ep;
+	set_activeblock(ep, bb);
+
+	entry = alloc_instruction(OP_ENTRY, 0);
+	add_one_insn(ep, entry);
+	ep->entry = entry;
+
+	concat_symbol_list(base_type->arguments, &ep->syms);
+
+	/* FIXME!! We should do something else about varargs.. */
+	i = 0;
+	FOR_EACH_PTR(base_type->arguments, arg) {
+		linearize_argument(ep, arg, ++i);
+	} END_FOR_EACH_PTR(arg);
+
+	result = linearize_statement(ep, base_type->stmt);
+	if (bb_reachable(ep->active) && !bb_terminated(ep->active)) {
+		struct symbol *ret_type = base_type->ctype.base_type;
+		struct instruction *insn = alloc_typed_instruction(OP_RET, ret_type);
+
+		if (type_size(ret_type) > 0)
+			use_pseudo(insn, result, &insn->src);
+		add_one_insn(ep, insn);
+	}
 
+	run_passes(ep);
 	return ep;
 }
 
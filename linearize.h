@@ -31,6 +31,7 @@ enum pseudo_type {
 struct pseudo {
 	int nr;
 	enum pseudo_type type;
+	int live_nr;		/* bit number while the liveness is worked out */
 	struct pseudo_user_list *users;
 	struct ident *ident;
 	union {
@@ -233,6 +234,8 @@ struct basic_block {
 	struct basic_block_list *children; /* destinations */
 	struct instruction_list *insns;	/* Linear list of instructions */
 	struct pseudo_list *needs, *defines;
+	unsigned long *needs_map, *defines_map;	/* only used by liveness.c */
+	int needs_done;
 	void *priv;
 };
 
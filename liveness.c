@@ -6,11 +6,14 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "parse.h"
 #include "expression.h"
 #include "linearize.h"
 #include "flow.h"
+#include "bitmap.h"
 
 static void phi_defines(struct instruction * phi_node, pseudo_t target,
 	void (*defines)(struct basic_block *, struct instruction *, pseudo_t))
@@ -171,17 +174,84 @@ int pseudo_in_list(struct pseudo_list *list, pseudo_t pseudo)
 
 static int liveness_changed;
 
-static void add_pseudo_exclusive(struct pseudo_list **list, pseudo_t pseudo)
+static inline int trackable_pseudo(pseudo_t pseudo)
 {
-	if (!pseudo_in_list(*list, pseudo)) {
-		liveness_changed = 1;
-		add_pseudo(list, pseudo);
+	return pseudo && (pseudo->type == PSEUDO_REG || pseudo->type == PSEUDO_ARG);
+}
+
+/*
+ * The pseudos get numbered for each entrypoint so that the needs and
+ * defines of a bb can be looked up in a bitmap instead of scanning the
+ * lists.  The lists are still built in the same order as before, the
+ * bitmaps only answer "is it in there?".
+ */
+static pseudo_t *numbered;
+static int nr_numbered, numbered_alloc;
+static int map_longs;
+
+static void number_pseudo(struct basic_block *bb, struct instruction *insn, pseudo_t pseudo)
+{
+	if (!trackable_pseudo(pseudo) || pseudo->live_nr)
+		return;
+	if (nr_numbered == numbered_alloc) {
+		numbered_alloc = numbered_alloc ? numbered_alloc * 2 : 256;
+		numbered = realloc(numbered, numbered_alloc * sizeof(*numbered));
+		if (!numbered)
+			die("out of memory");
 	}
+	numbered[nr_numbered++] = pseudo;
+	pseudo->live_nr = nr_numbered;
 }
 
-static inline int trackable_pseudo(pseudo_t pseudo)
+static void number_pseudos(struct entrypoint *ep)
 {
-	return pseudo && (pseudo->type == PSEUDO_REG || pseudo->type == PSEUDO_ARG);
+	struct basic_block *bb;
+	pseudo_t pseudo;
+
+	FOR_EACH_PTR(ep->bbs, bb) {
+		struct instruction *insn;
+		FOR_EACH_PTR(bb->insns, insn) {
+			if (!insn->bb)
+				continue;
+			track_instruction_usage(bb, insn, number_pseudo, number_pseudo);
+		} END_FOR_EACH_PTR(insn);
+		FOR_EACH_PTR(bb->needs, pseudo) {
+			number_pseudo(bb, NULL, pseudo);
+		} END_FOR_EACH_PTR(pseudo);
+	} END_FOR_EACH_PTR(bb);
+	map_longs = (nr_numbered + BITS_IN_LONG - 1) / BITS_IN_LONG;
+}
+
+static void forget_pseudo_numbers(void)
+{
+	int i;
+
+	for (i = 0; i < nr_numbered; i++)
+		numbered[i]->live_nr = 0;
+	nr_numbered = 0;
+}
+
+static unsigned long *alloc_pseudo_map(void)
+{
+	unsigned long *map;
+
+	map = calloc(map_longs ? map_longs : 1, sizeof(unsigned long));
+	if (!map)
+		die("out of memory");
+	return map;
+}
+
+static inline int pseudo_in_map(pseudo_t pseudo, unsigned long *map)
+{
+	return test_bit(pseudo->live_nr - 1, map);
+}
+
+static void add_need(struct basic_block *bb, pseudo_t pseudo)
+{
+	if (!test_and_set_bit(pseudo->live_nr - 1, bb->needs_map)) {
+		liveness_changed = 1;
+		add_pseudo(&bb->needs, pseudo);
+	}
 }
 
 static void insn_uses(struct basic_block *bb, struct instruction *insn, pseudo_t pseudo)
@@ -189,7 +259,7 @@ static void insn_uses(struct basic_block *bb, struct instruction *insn, pseudo_t
 	if (trackable_pseudo(pseudo)) {
 		struct instruction *def = pseudo->def;
 		if (pseudo->type != PSEUDO_REG || def->bb != bb || def->opcode == OP_PHI)
-			add_pseudo_exclusive(&bb->needs, pseudo);
+			add_need(bb, pseudo);
 	}
 }
 
@@ -197,20 +267,29 @@ static void insn_defines(struct basic_block *bb, struct instruction *insn, pseud
 {
 	assert(trackable_pseudo(pseudo));
 	add_pseudo(&bb->defines, pseudo);
+	if (bb->defines_map)
+		set_bit(pseudo->live_nr - 1, bb->defines_map);
 }
 
+/*
+ * The needs we pushed up to the parents last time can't have changed since
+ * the parent's needs only grow, so only look at the new ones.
+ */
 static void track_bb_liveness(struct basic_block *bb)
 {
 	pseudo_t needs;
+	int nr = 0;
 
 	FOR_EACH_PTR(bb->needs, needs) {
 		struct basic_block *parent;
+		if (nr++ < bb->needs_done)
+			continue;
 		FOR_EACH_PTR(bb->parents, parent) {
-			if (!pseudo_in_list(parent->defines, needs)) {
-				add_pseudo_exclusive(&parent->needs, needs);
-			}
+			if (!pseudo_in_map(needs, parent->defines_map))
+				add_need(parent, needs);
 		} END_FOR_EACH_PTR(parent);
 	} END_FOR_EACH_PTR(needs);
+	bb->needs_done = nr;
 }
 
 /*
@@ -235,6 +314,13 @@ void track_pseudo_liveness(struct entrypoint *ep)
 {
 	struct basic_block *bb;
 
+	number_pseudos(ep);
+	FOR_EACH_PTR(ep->bbs, bb) {
+		bb->needs_map = alloc_pseudo_map();
+		bb->defines_map = alloc_pseudo_map();
+		bb->needs_done = 0;
+	} END_FOR_EACH_PTR(bb);
+
 	/* Add all the bb pseudo usage */
 	FOR_EACH_PTR(ep->bbs, bb) {
 		struct instruction *insn;
@@ -260,7 +346,7 @@ void track_pseudo_liveness(struct entrypoint *ep)
 		FOR_EACH_PTR(bb->defines, def) {
 			struct basic_block *child;
 			FOR_EACH_PTR(bb->children, child) {
-				if (pseudo_in_list(child->needs, def))
+				if (pseudo_in_map(def, child->needs_map))
 					goto is_used;
 			} END_FOR_EACH_PTR(child);
 			DELETE_CURRENT_PTR(def);
@@ -269,14 +355,14 @@ is_used:
 		} END_FOR_EACH_PTR(def);
 		PACK_PTR_LIST(&bb->defines);
 	} END_FOR_EACH_PTR(bb);
-}
 
-static void merge_pseudo_list(struct pseudo_list *src, struct pseudo_list **dest)
-{
-	pseudo_t pseudo;
-	FOR_EACH_PTR(src, pseudo) {
-		add_pseudo_exclusive(dest, pseudo);
-	} END_FOR_EACH_PTR(pseudo);
+	FOR_EACH_PTR(ep->bbs, bb) {
+		free(bb->needs_map);
+		free(bb->defines_map);
+		bb->needs_map = NULL;
+		bb->defines_map = NULL;
+	} END_FOR_EACH_PTR(bb);
+	forget_pseudo_numbers();
 }
 
 void track_phi_uses(struct instruction *insn)
@@ -302,6 +388,7 @@ static void track_bb_phi_uses(struct basic_block *bb)
 }
 
 static struct pseudo_list **live_list;
+static unsigned long *live_map;
 static struct pseudo_list *dead_list;
 
 static void death_def(struct basic_block *bb, struct instruction *insn, pseudo_t pseudo)
@@ -310,7 +397,7 @@ static void death_def(struct basic_block *bb, struct instruction *insn, pseudo_t
 
 static void death_use(struct basic_block *bb, struct instruction *insn, pseudo_t pseudo)
 {
-	if (trackable_pseudo(pseudo) && !pseudo_in_list(*live_list, pseudo)) {
+	if (trackable_pseudo(pseudo) && !test_and_set_bit(pseudo->live_nr - 1, live_map)) {
 		add_pseudo(&dead_list, pseudo);
 		add_pseudo(live_list, pseudo);
 	}
@@ -321,9 +408,14 @@ static void track_pseudo_death_bb(struct basic_block *bb)
 	struct pseudo_list *live = NULL;
 	struct basic_block *child;
 	struct instruction *insn;
+	pseudo_t pseudo;
 
+	memset(live_map, 0, map_longs * sizeof(unsigned long));
 	FOR_EACH_PTR(bb->children, child) {
-		merge_pseudo_list(child->needs, &live);
+		FOR_EACH_PTR(child->needs, pseudo) {
+			if (!test_and_set_bit(pseudo->live_nr - 1, live_map))
+				add_pseudo(&live, pseudo);
+		} END_FOR_EACH_PTR(pseudo);
 	} END_FOR_EACH_PTR(child);
 
 	live_list = &live;
@@ -356,7 +448,12 @@ void track_pseudo_death(struct entrypoint *ep)
 		track_bb_phi_uses(bb);
 	} END_FOR_EACH_PTR(bb);
 
+	number_pseudos(ep);
+	live_map = alloc_pseudo_map();
 	FOR_EACH_PTR(ep->bbs, bb) {
 		track_pseudo_death_bb(bb);
 	} END_FOR_EACH_PTR(bb);
+	free(live_map);
+	live_map = NULL;
+	forget_pseudo_numbers();
 }
@@ -2609,13 +2609,21 @@ static int is_syscall(struct symbol *sym)
 }
     
 
-static struct token *parse_function_body(struct token *token, struct symbol *decl,
-	struct symbol_list **list)
+/*
+ * With flazy_inline set the bodies of inline functions are skipped when the
+ * file is parsed and parse_lazy_body() parses them the first time someone
+ * needs them.  Most of the inline functions from headers are never used so
+ * this saves building statements and scopes for them.  It isn't a -f option
+ * because every user of the inline bodies has to call parse_lazy_body() and
+ * the tokens have to stay around, so only Smatch turns it on.
+ */
+int flazy_inline;
+
+static struct token *function_body(struct token *token, struct symbol *decl)
 {
 	struct symbol_list **old_symbol_list;
 	struct symbol *base_type = decl->ctype.base_type;
 	struct statement *stmt, **p;
-	struct symbol *prev;
 	struct symbol *arg;
 
 	old_symbol_list = function_symbol_list;
@@ -2629,13 +2637,6 @@ static struct token *parse_function_body(struct token *token, struct symbol *dec
 	function_computed_target_list = NULL;
 	function_computed_goto_list = NULL;
 
-	if (decl->ctype.modifiers & MOD_EXTERN) {
-		if (!(decl->ctype.modifiers & MOD_INLINE))
-			warning(decl->pos, "function '%s' with external linkage has definition", show_ident(decl->ident));
-	}
-	if (!(decl->ctype.modifiers & MOD_STATIC))
-		decl->ctype.modifiers |= MOD_EXTERN;
-
 	stmt = start_function(decl);
 
 	*p = stmt;
@@ -2646,6 +2647,71 @@ static struct token *parse_function_body(struct token *token, struct symbol *dec
 	token = compound_statement(token->next, stmt);
 
 	end_function(decl); 
+	function_symbol_list = old_symbol_list;
+	if (function_computed_goto_list) {
+		if (!function_computed_target_list)
+			warning(decl->pos, "function '%s' has computed goto but no targets?", show_ident(decl->ident));
+		else {
+			FOR_EACH_PTR(function_computed_goto_list, stmt) {
+				stmt->target_list = function_computed_target_list;
+			} END_FOR_EACH_PTR(stmt);
+		}
+	}
+	return token;
+}
+
+static struct token *skip_function_body(struct token *token)
+{
+	int depth = 0;
+
+	for (; !eof_token(token); token = token->next) {
+		if (match_op(token, '{'))
+			depth++;
+		else if (match_op(token, '}') && !--depth)
+			return token;
+	}
+	return NULL;
+}
+
+/*
+ * This has to be called at file scope after the file has been parsed, the
+ * body sees every symbol declared in the file.
+ */
+void parse_lazy_body(struct symbol *sym)
+{
+	struct token *token;
+
+	if (sym->definition)
+		sym = sym->definition;
+	token = sym->lazy_body;
+	if (!token)
+		return;
+	sym->lazy_body = NULL;
+	function_body(token, sym);
+}
+
+static struct token *parse_function_body(struct token *token, struct symbol *decl,
+	struct symbol_list **list)
+{
+	struct token *end = NULL;
+	struct symbol *prev;
+
+	if (decl->ctype.modifiers & MOD_EXTERN) {
+		if (!(decl->ctype.modifiers & MOD_INLINE))
+			warning(decl->pos, "function '%s' with external linkage has definition", show_ident(decl->ident));
+	}
+	if (!(decl->ctype.modifiers & MOD_STATIC))
+		decl->ctype.modifiers |= MOD_EXTERN;
+
+	if (flazy_inline && (decl->ctype.modifiers & MOD_INLINE))
+		end = skip_function_body(token);
+	if (end) {
+		decl->lazy_body = token;
+		token = end;
+	} else {
+		token = function_body(token, decl);
+	}
+
 	/*
 	if (!(decl->ctype.modifiers & MOD_INLINE))
 		add_symbol(list, decl);
@@ -2671,16 +2737,6 @@ static struct token *parse_function_body(struct token *token, struct symbol *dec
 			prev = prev->same_symbol;
 		}
 	}
-	function_symbol_list = old_symbol_list;
-	if (function_computed_goto_list) {
-		if (!function_computed_target_list)
-			warning(decl->pos, "function '%s' has computed goto but no targets?", show_ident(decl->ident));
-		else {
-			FOR_EACH_PTR(function_computed_goto_list, stmt) {
-				stmt->target_list = function_computed_target_list;
-			} END_FOR_EACH_PTR(stmt);
-		}
-	}
 	return expect(token, '}', "at end of function");
 }
 
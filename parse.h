@@ -146,6 +146,8 @@ extern struct symbol *ctype_integer(int size, int want_unsigned);
 extern void copy_statement(struct statement *src, struct statement *dst);
 extern int inline_function(struct expression *expr, struct symbol *sym);
 extern void uninline(struct symbol *sym);
+extern int flazy_inline;
+extern void parse_lazy_body(struct symbol *sym);
 extern void init_parser(int);
 
 static inline void stmt_set_parent_stmt(struct statement *stmt, struct statement *parent)
@@ -48,6 +48,35 @@
 
 static int false_nesting = 0;
 
+/*
+ * Object-like macros such as GFP_KERNEL or __user, and function-like macros
+ * which don't use their arguments such as barrier(), are expanded over and
+ * over with the same definitions.  The first time one of them is expanded
+ * outside of any other expansion we save the fully rescanned result and the
+ * next time we only have to copy it.
+ *
+ * Every #define and #undef stamps the macro with a new generation.  The
+ * saved expansion is thrown away if the macro itself, one of the macros it
+ * expanded or one of the identifiers in the result has been defined or
+ * undefined since it was saved.  It isn't saved if the result depends on
+ * where the macro was used (__LINE__, __FILE__, ...) or if the rescan ate
+ * tokens from after the macro.
+ */
+int fmacro_cache = 1;
+static unsigned int macro_generation;
+static unsigned int run_generation;
+static int tainted_count;
+static int collecting_args;
+static int in_if_expression;
+
+static struct ident *fill_ident;
+static struct symbol *fill_sym;
+static struct token **fill_list;
+static struct position fill_pos;
+static unsigned int fill_generation;
+static struct symbol_list *fill_deps;
+static int fill_bad;
+
 #define INCLUDEPATHS 300
 const char *includepath[INCLUDEPATHS+1] = {
 	"",
@@ -170,6 +199,11 @@ static int expand_one_symbol(struct token **list)
 		sym->used_in = file_scope;
 		return expand(list, sym);
 	}
+	if (fill_ident && (token->ident == &__LINE___ident ||
+			   token->ident == &__FILE___ident ||
+			   token->ident == &__DATE___ident ||
+			   token->ident == &__TIME___ident))
+		fill_bad = 1;
 	if (token->ident == &__LINE___ident) {
 		replace_with_integer(token, token->pos.line);
 	} else if (token->ident == &__FILE___ident) {
@@ -188,13 +222,20 @@ static int expand_one_symbol(struct token **list)
 	return 1;
 }
 
+static void finish_fill(struct token *end);
+
 static inline struct token *scan_next(struct token **where)
 {
 	struct token *token = *where;
 	if (token_type(token) != TOKEN_UNTAINT)
 		return token;
 	do {
-		token->ident->tainted = 0;
+		if (token->ident->tainted) {
+			token->ident->tainted = 0;
+			tainted_count--;
+			if (token->ident == fill_ident)
+				finish_fill(token);
+		}
 		token = token->next;
 	} while (token_type(token) == TOKEN_UNTAINT);
 	*where = token;
@@ -696,6 +737,142 @@ static struct token **substitute(struct token **list, struct token *body, struct
 	return list;
 }
 
+static void finish_fill(struct token *end)
+{
+	struct token *cached = NULL;
+	struct token **p = &cached;
+	struct token *token, *prev = NULL;
+
+	fill_ident = NULL;
+	if (fill_bad || collecting_args || tainted_count ||
+	    fill_generation != macro_generation)
+		goto out;
+
+	for (token = *fill_list; token != end; token = token->next) {
+		if (eof_token(token))
+			goto out;
+		if (token_type(token) == TOKEN_UNTAINT)
+			continue;
+		if (token->pos.stream != fill_pos.stream ||
+		    token->pos.line != fill_pos.line ||
+		    token->pos.pos != fill_pos.pos)
+			goto out;
+		prev = token;
+	}
+	/* a function-like macro at the end could take the tokens after it */
+	if (prev && token_type(prev) == TOKEN_IDENT && !prev->pos.noexpand &&
+	    lookup_macro(prev->ident))
+		goto out;
+
+	for (token = *fill_list; token != end; token = token->next) {
+		if (token_type(token) == TOKEN_UNTAINT)
+			continue;
+		*p = dup_token(token, &token->pos);
+		p = &(*p)->next;
+	}
+	*p = &eof_token_entry;
+
+	free_ptr_list(&fill_sym->cache_deps);
+	fill_sym->cached_expansion = cached;
+	fill_sym->cache_generation = macro_generation;
+	fill_sym->cache_deps = fill_deps;
+	fill_deps = NULL;
+out:
+	free_ptr_list(&fill_deps);
+}
+
+static int macro_uses_args(struct symbol *sym)
+{
+	struct token *token;
+
+	for (token = sym->expansion; !eof_token(token); token = token->next) {
+		switch (token_type(token)) {
+		case TOKEN_MACRO_ARGUMENT:
+		case TOKEN_STR_ARGUMENT:
+		case TOKEN_QUOTED_ARGUMENT:
+		case TOKEN_GNU_KLUDGE:
+			return 1;
+		default:
+			break;
+		}
+	}
+	return 0;
+}
+
+static int can_use_macro_cache(struct symbol *sym)
+{
+	if (!fmacro_cache || tainted_count || in_if_expression)
+		return 0;
+	if (sym->arglist && macro_uses_args(sym))
+		return 0;
+	return 1;
+}
+
+static int macro_changed(struct ident *ident, unsigned int generation)
+{
+	struct symbol *sym = lookup_symbol(ident, NS_MACRO | NS_UNDEF);
+
+	return sym && sym->define_generation > generation;
+}
+
+static int macro_cache_valid(struct symbol *sym)
+{
+	unsigned int generation = sym->cache_generation;
+	struct symbol *dep;
+	struct token *token;
+
+	if (!sym->cached_expansion || generation < run_generation ||
+	    sym->define_generation > generation)
+		return 0;
+	FOR_EACH_PTR(sym->cache_deps, dep) {
+		if (macro_changed(dep->ident, generation))
+			return 0;
+	} END_FOR_EACH_PTR(dep);
+	for (token = sym->cached_expansion; !eof_token(token); token = token->next) {
+		if (token_type(token) == TOKEN_IDENT &&
+		    macro_changed(token->ident, generation))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * The saved expansion has been rescanned already so the caller has to carry
+ * on after it.  The macro name is turned into the last token of the
+ * expansion and we return 1 like for a macro which wasn't expanded.
+ *
+ * The tokens are linked through their own ->next and each one has its own
+ * position so the saved list can't be shared; the other tokens are copied.
+ */
+static int expand_from_cache(struct token **list, struct symbol *sym)
+{
+	struct token *token = *list;
+	struct token *cached = sym->cached_expansion;
+	struct token **p = list;
+
+	if (eof_token(cached)) {
+		*list = token->next;
+		return 0;
+	}
+
+	for (; !eof_token(cached->next); cached = cached->next) {
+		*p = dup_token(cached, &token->pos);
+		p = &(*p)->next;
+	}
+	*p = token;
+
+	if (*list != token) {
+		(*list)->pos.newline = token->pos.newline;
+		(*list)->pos.whitespace = token->pos.whitespace;
+		token->pos.newline = cached->pos.newline;
+		token->pos.whitespace = cached->pos.whitespace;
+	}
+	token_type(token) = token_type(cached);
+	token->number = cached->number;
+	token->pos.noexpand = cached->pos.noexpand;
+	return 1;
+}
+
 static int expand(struct token **list, struct symbol *sym)
 {
 	struct token *last;
@@ -704,21 +881,42 @@ static int expand(struct token **list, struct symbol *sym)
 	struct token **tail;
 	int nargs = sym->arglist ? sym->arglist->count.normal : 0;
 	struct arg args[nargs];
+	int fill = 0, hit = 0;
+	int ret;
 
 	if (expanding->tainted) {
 		token->pos.noexpand = 1;
 		return 1;
 	}
 
+	if (can_use_macro_cache(sym)) {
+		if (macro_cache_valid(sym))
+			hit = 1;
+		else
+			fill = 1;
+	}
+
 	if (sym->arglist) {
 		if (!match_op(scan_next(&token->next), '('))
 			return 1;
-		if (!collect_arguments(token->next, sym->arglist, args, token))
+		collecting_args++;
+		ret = collect_arguments(token->next, sym->arglist, args, token);
+		collecting_args--;
+		if (!ret)
 			return 1;
-		expand_arguments(nargs, args);
+		if (!hit)
+			expand_arguments(nargs, args);
 	}
 
+	if (hit)
+		return expand_from_cache(list, sym);
+
+	/* the saved expansion depends on the macros it expands */
+	if (fill_ident)
+		add_ptr_list(&fill_deps, sym);
+
 	expanding->tainted = 1;
+	tainted_count++;
 
 	last = token->next;
 	tail = substitute(list, sym->expansion, args);
@@ -732,6 +930,24 @@ static int expand(struct token **list, struct symbol *sym)
 	(*list)->pos.whitespace = token->pos.whitespace;
 	*tail = last;
 
+	/*
+	 * If a macro inside the one we are saving expands to nothing then
+	 * the flags above end up on the wrong token.
+	 */
+	if (fill_ident && expanding != fill_ident &&
+	    token_type(*list) == TOKEN_UNTAINT)
+		fill_bad = 1;
+
+	if (fill) {
+		fill_ident = expanding;
+		fill_sym = sym;
+		fill_list = list;
+		fill_pos = token->pos;
+		fill_generation = macro_generation;
+		free_ptr_list(&fill_deps);
+		fill_bad = 0;
+	}
+
 	return 0;
 }
 
@@ -1470,6 +1686,7 @@ static int do_handle_define(struct stream *stream, struct token **line, struct t
 		__free_token(token);	/* Free the "define" token, but not the rest of the line */
 	}
 
+	sym->define_generation = ++macro_generation;
 	sym->namespace = NS_MACRO;
 	sym->used_in = NULL;
 	sym->attr = attr;
@@ -1516,6 +1733,7 @@ static int do_handle_undef(struct stream *stream, struct token **line, struct to
 		bind_symbol(sym, left->ident, NS_MACRO);
 	}
 
+	sym->define_generation = ++macro_generation;
 	sym->namespace = NS_UNDEF;
 	sym->used_in = NULL;
 	sym->attr = attr;
@@ -1598,6 +1816,7 @@ static int expression_value(struct token **where)
 	long long value;
 	int state = 0;
 
+	in_if_expression++;
 	while (!eof_token(p = scan_next(list))) {
 		switch (state) {
 		case 0:
@@ -1640,6 +1859,7 @@ static int expression_value(struct token **where)
 		}
 		list = &p->next;
 	}
+	in_if_expression--;
 
 	p = constant_expression(*where, &expr);
 	if (!eof_token(p))
@@ -2139,6 +2359,7 @@ void init_include_path(void)
 struct token * preprocess(struct token *token)
 {
 	preprocessing = 1;
+	run_generation = ++macro_generation;
 	init_preprocessor();
 	do_preprocess(&token);
 
@@ -0,0 +1,1112 @@
+/*
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * sindex - a symbol and cross reference index for a whole tree
+ *
+ *   sindex build [-j <jobs>] [-o <index>] [-v] [sparse options] <files...>
+ *   sindex search [-i <index>] <name>
+ *
+ * "build" runs the dissect() reporters over the files.  Sparse keeps all its
+ * state in globals so every file is done in a forked child, with up to
+ * <jobs> of them running at once.  All the definitions and uses end up in a
+ * single index file.
+ *
+ * The index remembers every file that a TU pulled in along with its size
+ * and mtime.  Running "build" again only redoes the TUs where one of those
+ * changed.  TUs in the old index which aren't on the command line are kept
+ * as long as their file is still there.  -v prints the files which are
+ * indexed.
+ *
+ * A reference from a header is seen by every TU which includes it.  It's
+ * stored once along with the list of TUs which saw it, so when a TU is redone
+ * only its claim on the reference is dropped.
+ *
+ * "search" mmap()s the index.  The references are sorted by name so a lookup
+ * is a binary search.  Struct members are called "struct.member".
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "dissect.h"
+
+#define INDEX_MAGIC	"SINDEX2"
+
+struct index_header {
+	char magic[8];
+	uint32_t nr_files, nr_tus, nr_deps, nr_refs, nr_owners;
+	uint32_t strings_size;
+	uint32_t files_off, tus_off, deps_off, refs_off, owners_off, strings_off;
+};
+
+struct index_file {
+	int64_t mtime;
+	int64_t size;
+	uint32_t name;
+	uint32_t unused;
+};
+
+struct index_tu {
+	uint32_t file;
+	uint32_t first_dep, nr_deps;
+};
+
+struct index_ref {
+	uint32_t name;
+	uint32_t file;
+	uint32_t line, col;
+	uint32_t mode;		/* -1 for the definition */
+	uint32_t storage;	/* 'g'lobal, 's'tatic or 'l'ocal */
+	uint32_t first_owner, nr_owners;	/* the TUs which saw it */
+};
+/* most references are only seen by one TU so that is stored in first_owner */
+#define REF_OWNER(idx, ref, i) \
+	((ref)->nr_owners == 1 ? (ref)->first_owner : (idx)->owners[(ref)->first_owner + (i)])
+
+struct ref_owner {
+	uint32_t ref;
+	uint32_t tu;
+};
+
+static void *xrealloc(void *ptr, size_t size)
+{
+	ptr = realloc(ptr, size);
+	if (!ptr)
+		die("out of memory");
+	return ptr;
+}
+
+#define GROW(array, nr, alloc) do {					\
+	if ((nr) == (alloc)) {						\
+		(alloc) = (alloc) ? (alloc) * 2 : 64;			\
+		(array) = xrealloc((array), (alloc) * sizeof(*(array)));\
+	}								\
+} while (0)
+
+/* The index being built */
+
+static char *strings;
+static uint32_t strings_size, strings_alloc;
+static uint32_t *string_hash;
+static uint32_t string_hash_size, nr_hashed;
+
+struct file_info {
+	struct index_file disk;
+	int checked;		/* has been stat()ed */
+	int changed;
+	int listed;		/* on the command line */
+	int done;		/* has a TU in the new index */
+};
+
+static int show_files;	/* -v */
+
+static struct file_info *files;
+static uint32_t nr_files, files_alloc;
+static uint32_t *file_hash;
+static uint32_t file_hash_size;
+
+static struct index_tu *tus;
+static uint32_t nr_tus, tus_alloc;
+static uint32_t *deps;
+static uint32_t nr_deps, deps_alloc;
+static struct index_ref *refs;
+static uint32_t nr_refs, refs_alloc;
+static uint32_t *ref_hash;
+static uint32_t ref_hash_size;
+static struct ref_owner *owners;
+static uint32_t nr_owners, owners_alloc;
+
+static uint32_t hash_string(const char *str)
+{
+	uint32_t hash = 5381;
+
+	while (*str)
+		hash = hash * 33 + (unsigned char)*str++;
+	return hash;
+}
+
+static void rehash_strings(void)
+{
+	uint32_t *old = string_hash;
+	uint32_t old_size = string_hash_size;
+	uint32_t i, slot;
+
+	string_hash_size = old_size ? old_size * 2 : 1024;
+	string_hash = calloc(string_hash_size, sizeof(*string_hash));
+	if (!string_hash)
+		die("out of memory");
+	for (i = 0; i < old_size; i++) {
+		if (!old[i])
+			continue;
+		slot = hash_string(strings + old[i] - 1) & (string_hash_size - 1);
+		while (string_hash[slot])
+			slot = (slot + 1) & (string_hash_size - 1);
+		string_hash[slot] = old[i];
+	}
+	free(old);
+}
+
+static uint32_t intern(const char *str)
+{
+	uint32_t slot, len;
+
+	if (nr_hashed * 2 >= string_hash_size)
+		rehash_strings();
+
+	slot = hash_string(str) & (string_hash_size - 1);
+	while (string_hash[slot]) {
+		if (strcmp(strings + string_hash[slot] - 1, str) == 0)
+			return string_hash[slot] - 1;
+		slot = (slot + 1) & (string_hash_size - 1);
+	}
+
+	len = strlen(str) + 1;
+	while (strings_size + len > strings_alloc) {
+		strings_alloc = strings_alloc ? strings_alloc * 2 : 65536;
+		strings = xrealloc(strings, strings_alloc);
+	}
+	memcpy(strings + strings_size, str, len);
+	string_hash[slot] = strings_size + 1;
+	nr_hashed++;
+	strings_size += len;
+	return strings_size - len;
+}
+
+static void rehash_files(void)
+{
+	uint32_t i, slot;
+
+	free(file_hash);
+	file_hash_size = file_hash_size ? file_hash_size * 2 : 1024;
+	file_hash = calloc(file_hash_size, sizeof(*file_hash));
+	if (!file_hash)
+		die("out of memory");
+	for (i = 0; i < nr_files; i++) {
+		slot = files[i].disk.name & (file_hash_size - 1);
+		while (file_hash[slot])
+			slot = (slot + 1) & (file_hash_size - 1);
+		file_hash[slot] = i + 1;
+	}
+}
+
+static uint32_t find_file(const char *name)
+{
+	uint32_t str = intern(name);
+	uint32_t slot;
+
+	if (nr_files * 2 >= file_hash_size)
+		rehash_files();
+
+	slot = str & (file_hash_size - 1);
+	while (file_hash[slot]) {
+		if (files[file_hash[slot] - 1].disk.name == str)
+			return file_hash[slot] - 1;
+		slot = (slot + 1) & (file_hash_size - 1);
+	}
+
+	GROW(files, nr_files, files_alloc);
+	memset(&files[nr_files], 0, sizeof(files[nr_files]));
+	files[nr_files].disk.name = str;
+	file_hash[slot] = nr_files + 1;
+	return nr_files++;
+}
+
+static void stat_file(uint32_t idx)
+{
+	struct file_info *file = &files[idx];
+	struct stat st;
+
+	if (file->checked)
+		return;
+	file->checked = 1;
+	if (stat(strings + file->disk.name, &st) < 0) {
+		file->disk.mtime = -1;
+		file->disk.size = -1;
+		return;
+	}
+	file->disk.mtime = st.st_mtime;
+	file->disk.size = st.st_size;
+}
+
+static uint32_t new_tu(uint32_t file)
+{
+	GROW(tus, nr_tus, tus_alloc);
+	tus[nr_tus].file = file;
+	tus[nr_tus].first_dep = nr_deps;
+	tus[nr_tus].nr_deps = 0;
+	files[file].done = 1;
+	return nr_tus++;
+}
+
+static void add_dep(uint32_t tu, uint32_t file)
+{
+	GROW(deps, nr_deps, deps_alloc);
+	deps[nr_deps++] = file;
+	tus[tu].nr_deps++;
+}
+
+static int same_ref(struct index_ref *a, struct index_ref *b)
+{
+	return a->name == b->name && a->file == b->file && a->line == b->line &&
+	       a->col == b->col && a->mode == b->mode && a->storage == b->storage;
+}
+
+static uint32_t hash_ref(struct index_ref *ref)
+{
+	uint32_t hash = ref->name;
+
+	hash = hash * 31 + ref->file;
+	hash = hash * 31 + ref->line;
+	hash = hash * 31 + ref->col;
+	hash = hash * 31 + ref->mode;
+	return hash * 31 + ref->storage;
+}
+
+static void rehash_refs(void)
+{
+	uint32_t i, slot;
+
+	free(ref_hash);
+	ref_hash_size = ref_hash_size ? ref_hash_size * 2 : 1024;
+	ref_hash = calloc(ref_hash_size, sizeof(*ref_hash));
+	if (!ref_hash)
+		die("out of memory");
+	for (i = 0; i < nr_refs; i++) {
+		slot = hash_ref(&refs[i]) & (ref_hash_size - 1);
+		while (ref_hash[slot])
+			slot = (slot + 1) & (ref_hash_size - 1);
+		ref_hash[slot] = i + 1;
+	}
+}
+
+static void add_ref(uint32_t tu, const char *name, const char *file,
+		    uint32_t line, uint32_t col, uint32_t mode, uint32_t storage)
+{
+	struct index_ref new = {
+		.name = intern(name),
+		.file = find_file(file),
+		.line = line,
+		.col = col,
+		.mode = mode,
+		.storage = storage,
+	};
+	uint32_t slot;
+
+	if (nr_refs * 2 >= ref_hash_size)
+		rehash_refs();
+
+	slot = hash_ref(&new) & (ref_hash_size - 1);
+	while (ref_hash[slot]) {
+		if (same_ref(&refs[ref_hash[slot] - 1], &new))
+			break;
+		slot = (slot + 1) & (ref_hash_size - 1);
+	}
+	if (!ref_hash[slot]) {
+		GROW(refs, nr_refs, refs_alloc);
+		refs[nr_refs] = new;
+		ref_hash[slot] = ++nr_refs;
+	}
+
+	GROW(owners, nr_owners, owners_alloc);
+	owners[nr_owners].ref = ref_hash[slot] - 1;
+	owners[nr_owners].tu = tu;
+	nr_owners++;
+}
+
+/* Reading an existing index */
+
+struct index {
+	void *map;
+	size_t size;
+	struct index_header *hdr;
+	struct index_file *files;
+	struct index_tu *tus;
+	uint32_t *deps;
+	struct index_ref *refs;
+	uint32_t *owners;
+	const char *strings;
+};
+
+static int bad_section(struct index *idx, uint32_t off, uint32_t nr, size_t size,
+		       size_t align)
+{
+	return off < sizeof(struct index_header) || off > idx->size ||
+	       off % align || nr > (idx->size - off) / size;
+}
+
+/* The index could be from an older sindex or cut short so check everything */
+static int bad_index(struct index *idx)
+{
+	struct index_header *hdr = idx->hdr;
+	struct index_ref *ref;
+	struct index_tu *tu;
+	uint32_t i;
+
+	if (memcmp(hdr->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+		return 1;
+	if (bad_section(idx, hdr->files_off, hdr->nr_files, sizeof(struct index_file), 8) ||
+	    bad_section(idx, hdr->tus_off, hdr->nr_tus, sizeof(struct index_tu), 4) ||
+	    bad_section(idx, hdr->deps_off, hdr->nr_deps, sizeof(uint32_t), 4) ||
+	    bad_section(idx, hdr->refs_off, hdr->nr_refs, sizeof(struct index_ref), 4) ||
+	    bad_section(idx, hdr->owners_off, hdr->nr_owners, sizeof(uint32_t), 4) ||
+	    bad_section(idx, hdr->strings_off, hdr->strings_size, 1, 1))
+		return 1;
+
+	idx->files = idx->map + hdr->files_off;
+	idx->tus = idx->map + hdr->tus_off;
+	idx->deps = idx->map + hdr->deps_off;
+	idx->refs = idx->map + hdr->refs_off;
+	idx->owners = idx->map + hdr->owners_off;
+	idx->strings = idx->map + hdr->strings_off;
+
+	/* every string has to end inside the table */
+	if (hdr->strings_size && idx->strings[hdr->strings_size - 1] != '\0')
+		return 1;
+	for (i = 0; i < hdr->nr_files; i++) {
+		if (idx->files[i].name >= hdr->strings_size)
+			return 1;
+	}
+	for (i = 0; i < hdr->nr_tus; i++) {
+		tu = &idx->tus[i];
+		if (tu->file >= hdr->nr_files || tu->first_dep > hdr->nr_deps ||
+		    tu->nr_deps > hdr->nr_deps - tu->first_dep)
+			return 1;
+	}
+	for (i = 0; i < hdr->nr_deps; i++) {
+		if (idx->deps[i] >= hdr->nr_files)
+			return 1;
+	}
+	for (i = 0; i < hdr->nr_refs; i++) {
+		ref = &idx->refs[i];
+		if (ref->name >= hdr->strings_size || ref->file >= hdr->nr_files)
+			return 1;
+		if (ref->nr_owners == 1) {
+			if (ref->first_owner >= hdr->nr_tus)
+				return 1;
+		} else if (ref->first_owner > hdr->nr_owners ||
+			   ref->nr_owners > hdr->nr_owners - ref->first_owner) {
+			return 1;
+		}
+	}
+	for (i = 0; i < hdr->nr_owners; i++) {
+		if (idx->owners[i] >= hdr->nr_tus)
+			return 1;
+	}
+	return 0;
+}
+
+static int open_index(const char *path, struct index *idx)
+{
+	struct stat st;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) < 0 || st.st_size < sizeof(struct index_header)) {
+		close(fd);
+		return -1;
+	}
+	idx->size = st.st_size;
+	idx->map = mmap(NULL, idx->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (idx->map == MAP_FAILED)
+		return -1;
+
+	idx->hdr = idx->map;
+	if (bad_index(idx)) {
+		munmap(idx->map, idx->size);
+		return -1;
+	}
+	return 0;
+}
+
+static int old_tu_changed(struct index *idx, struct index_tu *old)
+{
+	struct index_file *dep;
+	uint32_t file;
+	uint32_t i;
+
+	for (i = 0; i < old->nr_deps; i++) {
+		dep = &idx->files[idx->deps[old->first_dep + i]];
+		file = find_file(idx->strings + dep->name);
+		stat_file(file);
+		if (files[file].disk.mtime != dep->mtime ||
+		    files[file].disk.size != dep->size)
+			return 1;
+	}
+	return 0;
+}
+
+static void load_old_index(const char *path)
+{
+	struct index idx;
+	struct index_tu *old;
+	struct index_ref *ref;
+	uint32_t *map;
+	uint32_t file, tu, i, j;
+
+	if (open_index(path, &idx) < 0)
+		return;
+
+	/* old TU number to new TU number plus one, zero if it's redone */
+	map = calloc(idx.hdr->nr_tus + 1, sizeof(*map));
+	if (!map)
+		die("out of memory");
+
+	for (i = 0; i < idx.hdr->nr_tus; i++) {
+		old = &idx.tus[i];
+		file = find_file(idx.strings + idx.files[old->file].name);
+		stat_file(file);
+		if (files[file].disk.mtime == -1)
+			continue;
+		if (files[file].listed && old_tu_changed(&idx, old))
+			continue;
+		map[i] = new_tu(file) + 1;
+		for (j = 0; j < old->nr_deps; j++) {
+			struct index_file *dep = &idx.files[idx.deps[old->first_dep + j]];
+
+			file = find_file(idx.strings + dep->name);
+			/* keep what the TU saw if it wasn't checked again */
+			if (!files[file].checked) {
+				files[file].disk.mtime = dep->mtime;
+				files[file].disk.size = dep->size;
+			}
+			add_dep(nr_tus - 1, file);
+		}
+	}
+
+	for (i = 0; i < idx.hdr->nr_refs; i++) {
+		ref = &idx.refs[i];
+		for (j = 0; j < ref->nr_owners; j++) {
+			tu = REF_OWNER(&idx, ref, j);
+			if (!map[tu])
+				continue;
+			add_ref(map[tu] - 1, idx.strings + ref->name,
+				idx.strings + idx.files[ref->file].name,
+				ref->line, ref->col, ref->mode, ref->storage);
+		}
+	}
+
+	free(map);
+	munmap(idx.map, idx.size);
+}
+
+/* The child side: one TU */
+
+static FILE *out;
+static unsigned dotc_stream;
+
+static inline char storage(struct symbol *sym)
+{
+	int t = sym->type;
+	unsigned m = sym->ctype.modifiers;
+
+	if (m & MOD_INLINE || t == SYM_STRUCT || t == SYM_UNION)
+		return sym->pos.stream == dotc_stream ? 's' : 'g';
+
+	return (m & MOD_STATIC) ? 's' : (m & MOD_NONLOCAL) ? 'g' : 'l';
+}
+
+static void r_symbol(unsigned mode, struct position *pos, struct symbol *sym)
+{
+	if (!sym->ident)
+		sym->ident = MK_IDENT("__asm__");
+
+	fprintf(out, "R\t%d\t%d\t%u\t%c\t%.*s\t%s\n", pos->line, pos->pos, mode,
+		storage(sym), sym->ident->len, sym->ident->name,
+		stream_name(pos->stream));
+}
+
+static void r_member(unsigned mode, struct position *pos, struct symbol *sym, struct symbol *mem)
+{
+	struct ident *ni, *si, *mi;
+
+	ni = MK_IDENT("?");
+	si = sym->ident ?: ni;
+	/* mem == NULL means entire struct accessed */
+	mi = mem ? (mem->ident ?: ni) : MK_IDENT("*");
+
+	fprintf(out, "R\t%d\t%d\t%u\t%c\t%.*s.%.*s\t%s\n", pos->line, pos->pos,
+		mode, storage(sym), si->len, si->name, mi->len, mi->name,
+		stream_name(pos->stream));
+}
+
+static void r_symdef(struct symbol *sym)
+{
+	r_symbol(-1, &sym->pos, sym);
+}
+
+static void index_one_file(char *file, const char *tmp)
+{
+	static struct reporter reporter = {
+		.r_symdef = r_symdef,
+		.r_symbol = r_symbol,
+		.r_member = r_member,
+	};
+	struct stat st;
+	int i;
+
+	out = fopen(tmp, "w");
+	if (!out)
+		die("can't create %s: %s", tmp, strerror(errno));
+
+	dotc_stream = input_stream_nr;
+	dissect(__sparse(file), &reporter);
+
+	for (i = 0; i < input_stream_nr; i++) {
+		const char *name = stream_name(i);
+
+		if (stat(name, &st) == 0 && S_ISREG(st.st_mode))
+			fprintf(out, "D\t%s\n", name);
+	}
+	if (fclose(out))
+		die("can't write %s: %s", tmp, strerror(errno));
+	exit(0);
+}
+
+/* The parent side */
+
+static void read_results(uint32_t file, const char *tmp)
+{
+	char *line = NULL;
+	size_t alloc = 0;
+	ssize_t len;
+	uint32_t tu;
+	FILE *f;
+
+	f = fopen(tmp, "r");
+	if (!f)
+		die("can't read %s: %s", tmp, strerror(errno));
+
+	tu = new_tu(file);
+	while ((len = getline(&line, &alloc, f)) > 0) {
+		char *field[7];
+		char *p = line;
+		int nr = 0;
+
+		if (line[len - 1] == '\n')
+			line[len - 1] = '\0';
+		while (nr < 7) {
+			field[nr++] = p;
+			p = strchr(p, '\t');
+			if (!p)
+				break;
+			*p++ = '\0';
+		}
+		if (nr == 2 && strcmp(field[0], "D") == 0) {
+			uint32_t dep = find_file(field[1]);
+
+			stat_file(dep);
+			add_dep(tu, dep);
+		} else if (nr == 7 && strcmp(field[0], "R") == 0) {
+			add_ref(tu, field[5], field[6], strtoul(field[1], NULL, 10),
+				strtoul(field[2], NULL, 10),
+				strtoul(field[3], NULL, 10), field[4][0]);
+		}
+	}
+	free(line);
+	fclose(f);
+}
+
+struct job {
+	pid_t pid;
+	uint32_t file;
+	char tmp[PATH_MAX];
+};
+
+static void wait_for_job(struct job *jobs, int *running)
+{
+	int status, i;
+	pid_t pid;
+
+	pid = wait(&status);
+	if (pid < 0)
+		die("wait: %s", strerror(errno));
+
+	for (i = 0; i < *running; i++) {
+		if (jobs[i].pid == pid)
+			break;
+	}
+	if (i == *running)
+		return;
+
+	if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		read_results(jobs[i].file, jobs[i].tmp);
+	else
+		fprintf(stderr, "sindex: indexing %s failed\n",
+			strings + files[jobs[i].file].disk.name);
+	unlink(jobs[i].tmp);
+	jobs[i] = jobs[--*running];
+}
+
+static void run_jobs(struct string_list *filelist, const char *index, int nr_jobs)
+{
+	struct job *jobs;
+	int running = 0;
+	uint32_t idx;
+	char *file;
+
+	jobs = calloc(nr_jobs, sizeof(*jobs));
+	if (!jobs)
+		die("out of memory");
+
+	fflush(stdout);
+	fflush(stderr);
+	FOR_EACH_PTR_NOTAG(filelist, file) {
+		idx = find_file(file);
+		if (files[idx].done)
+			continue;
+		files[idx].done = 1;
+
+		if (running == nr_jobs)
+			wait_for_job(jobs, &running);
+
+		if (show_files) {
+			printf("%s\n", file);
+			fflush(stdout);
+		}
+
+		snprintf(jobs[running].tmp, sizeof(jobs[running].tmp),
+			 "%s.%u.tmp", index, idx);
+		jobs[running].file = idx;
+		jobs[running].pid = fork();
+		if (jobs[running].pid < 0)
+			die("fork: %s", strerror(errno));
+		if (jobs[running].pid == 0)
+			index_one_file(file, jobs[running].tmp);
+		running++;
+	} END_FOR_EACH_PTR_NOTAG(file);
+
+	while (running)
+		wait_for_job(jobs, &running);
+	free(jobs);
+}
+
+/* Writing the index */
+
+static char *old_strings;
+static struct file_info *old_files;
+static uint32_t *tu_order;
+
+static int compare_strings(const void *_a, const void *_b)
+{
+	const uint32_t *a = _a, *b = _b;
+
+	return strcmp(old_strings + *a, old_strings + *b);
+}
+
+static int compare_files(const void *_a, const void *_b)
+{
+	const uint32_t *a = _a, *b = _b;
+
+	return strcmp(old_strings + old_files[*a].disk.name,
+		      old_strings + old_files[*b].disk.name);
+}
+
+/*
+ * Rebuild the string table and the file table in sorted order.  After this
+ * comparing two offsets is the same as comparing the names and the same
+ * input always gives the same index no matter what order the jobs finished.
+ * Files which nothing refers to any more are dropped.
+ */
+static void canonicalize(void)
+{
+	uint32_t *names, *order, *file_map;
+	uint32_t nr_names = 0, nr_order = 0;
+	uint32_t i, name;
+
+	file_map = calloc(nr_files + 1, sizeof(*file_map));
+	names = malloc((nr_files + nr_refs + 1) * sizeof(*names));
+	order = malloc((nr_files + 1) * sizeof(*order));
+	if (!file_map || !names || !order)
+		die("out of memory");
+
+	for (i = 0; i < nr_tus; i++)
+		file_map[tus[i].file] = 1;
+	for (i = 0; i < nr_deps; i++)
+		file_map[deps[i]] = 1;
+	for (i = 0; i < nr_refs; i++)
+		file_map[refs[i].file] = 1;
+	for (i = 0; i < nr_files; i++) {
+		if (!file_map[i])
+			continue;
+		names[nr_names++] = files[i].disk.name;
+		order[nr_order++] = i;
+	}
+	for (i = 0; i < nr_refs; i++)
+		names[nr_names++] = refs[i].name;
+
+	old_strings = strings;
+	old_files = files;
+	qsort(names, nr_names, sizeof(*names), compare_strings);
+	qsort(order, nr_order, sizeof(*order), compare_files);
+
+	strings = NULL;
+	strings_size = strings_alloc = 0;
+	free(string_hash);
+	string_hash = NULL;
+	string_hash_size = nr_hashed = 0;
+	for (i = 0; i < nr_names; i++)
+		intern(old_strings + names[i]);
+
+	files = NULL;
+	nr_files = files_alloc = 0;
+	free(file_hash);
+	file_hash = NULL;
+	file_hash_size = 0;
+	for (i = 0; i < nr_order; i++) {
+		uint32_t new = find_file(old_strings + old_files[order[i]].disk.name);
+
+		name = files[new].disk.name;
+		files[new] = old_files[order[i]];
+		files[new].disk.name = name;
+		file_map[order[i]] = new;
+	}
+
+	for (i = 0; i < nr_tus; i++)
+		tus[i].file = file_map[tus[i].file];
+	for (i = 0; i < nr_deps; i++)
+		deps[i] = file_map[deps[i]];
+	for (i = 0; i < nr_refs; i++) {
+		refs[i].file = file_map[refs[i].file];
+		refs[i].name = intern(old_strings + refs[i].name);
+	}
+
+	free(old_strings);
+	free(old_files);
+	free(file_map);
+	free(names);
+	free(order);
+	old_strings = NULL;
+	old_files = NULL;
+}
+
+static int compare_refs(const void *_a, const void *_b)
+{
+	const struct index_ref *a = &refs[*(const uint32_t *)_a];
+	const struct index_ref *b = &refs[*(const uint32_t *)_b];
+
+	if (a->name != b->name)
+		return a->name < b->name ? -1 : 1;
+	if (a->file != b->file)
+		return a->file < b->file ? -1 : 1;
+	if (a->line != b->line)
+		return a->line < b->line ? -1 : 1;
+	if (a->col != b->col)
+		return a->col < b->col ? -1 : 1;
+	if (a->mode != b->mode)
+		return a->mode < b->mode ? -1 : 1;
+	if (a->storage != b->storage)
+		return a->storage < b->storage ? -1 : 1;
+	return 0;
+}
+
+static int compare_owners(const void *_a, const void *_b)
+{
+	const struct ref_owner *a = _a, *b = _b;
+
+	if (a->ref != b->ref)
+		return a->ref < b->ref ? -1 : 1;
+	if (a->tu != b->tu)
+		return a->tu < b->tu ? -1 : 1;
+	return 0;
+}
+
+static int compare_tus(const void *_a, const void *_b)
+{
+	const uint32_t *a = _a, *b = _b;
+
+	if (tus[*a].file == tus[*b].file)
+		return 0;
+	return tus[*a].file < tus[*b].file ? -1 : 1;
+}
+
+static void write_all(FILE *f, const void *data, size_t size)
+{
+	if (size && fwrite(data, size, 1, f) != 1)
+		die("can't write the index: %s", strerror(errno));
+}
+
+static void write_index(const char *path)
+{
+	struct index_header hdr;
+	struct index_file *disk_files;
+	struct index_tu *sorted_tus;
+	struct index_ref *sorted_refs;
+	uint32_t *sorted_deps, *sorted, *ref_order, *ref_map, *disk_owners;
+	char tmp[PATH_MAX];
+	uint32_t i, j, nr;
+	FILE *f;
+
+	canonicalize();
+
+	sorted = malloc((nr_tus + 1) * sizeof(*sorted));
+	tu_order = malloc((nr_tus + 1) * sizeof(*tu_order));
+	sorted_tus = malloc((nr_tus + 1) * sizeof(*sorted_tus));
+	sorted_deps = malloc((nr_deps + 1) * sizeof(*sorted_deps));
+	disk_files = malloc((nr_files + 1) * sizeof(*disk_files));
+	ref_order = malloc((nr_refs + 1) * sizeof(*ref_order));
+	ref_map = malloc((nr_refs + 1) * sizeof(*ref_map));
+	sorted_refs = malloc((nr_refs + 1) * sizeof(*sorted_refs));
+	disk_owners = malloc((nr_owners + 1) * sizeof(*disk_owners));
+	if (!sorted || !tu_order || !sorted_tus || !sorted_deps || !disk_files ||
+	    !ref_order || !ref_map || !sorted_refs || !disk_owners)
+		die("out of memory");
+	for (i = 0; i < nr_tus; i++)
+		sorted[i] = i;
+	qsort(sorted, nr_tus, sizeof(*sorted), compare_tus);
+	nr = 0;
+	for (i = 0; i < nr_tus; i++) {
+		struct index_tu *tu = &tus[sorted[i]];
+
+		tu_order[sorted[i]] = i;
+		sorted_tus[i].file = tu->file;
+		sorted_tus[i].first_dep = nr;
+		sorted_tus[i].nr_deps = tu->nr_deps;
+		for (j = 0; j < tu->nr_deps; j++)
+			sorted_deps[nr++] = deps[tu->first_dep + j];
+	}
+
+	for (i = 0; i < nr_refs; i++)
+		ref_order[i] = i;
+	qsort(ref_order, nr_refs, sizeof(*ref_order), compare_refs);
+	for (i = 0; i < nr_refs; i++) {
+		ref_map[ref_order[i]] = i;
+		sorted_refs[i] = refs[ref_order[i]];
+		sorted_refs[i].first_owner = 0;
+		sorted_refs[i].nr_owners = 0;
+	}
+
+	/* a TU can report the same reference twice */
+	for (i = 0; i < nr_owners; i++) {
+		owners[i].ref = ref_map[owners[i].ref];
+		owners[i].tu = tu_order[owners[i].tu];
+	}
+	qsort(owners, nr_owners, sizeof(*owners), compare_owners);
+	nr = 0;
+	for (i = 0; i < nr_owners; i++) {
+		struct index_ref *ref = &sorted_refs[owners[i].ref];
+
+		if (i && compare_owners(&owners[i - 1], &owners[i]) == 0)
+			continue;
+		if (!ref->nr_owners)
+			ref->first_owner = nr;
+		ref->nr_owners++;
+		disk_owners[nr++] = owners[i].tu;
+	}
+	/* move the single owners into the refs and pack the rest */
+	j = 0;
+	for (i = 0; i < nr_refs; i++) {
+		struct index_ref *ref = &sorted_refs[i];
+
+		if (ref->nr_owners == 1) {
+			ref->first_owner = disk_owners[ref->first_owner];
+			continue;
+		}
+		memmove(&disk_owners[j], &disk_owners[ref->first_owner],
+			ref->nr_owners * sizeof(*disk_owners));
+		ref->first_owner = j;
+		j += ref->nr_owners;
+	}
+	nr = j;
+
+	for (i = 0; i < nr_files; i++)
+		disk_files[i] = files[i].disk;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	hdr.nr_files = nr_files;
+	hdr.nr_tus = nr_tus;
+	hdr.nr_deps = nr_deps;
+	hdr.nr_refs = nr_refs;
+	hdr.nr_owners = nr;
+	hdr.strings_size = strings_size;
+	hdr.files_off = sizeof(hdr);
+	hdr.tus_off = hdr.files_off + nr_files * sizeof(struct index_file);
+	hdr.deps_off = hdr.tus_off + nr_tus * sizeof(struct index_tu);
+	hdr.refs_off = hdr.deps_off + nr_deps * sizeof(uint32_t);
+	hdr.owners_off = hdr.refs_off + nr_refs * sizeof(struct index_ref);
+	hdr.strings_off = hdr.owners_off + hdr.nr_owners * sizeof(uint32_t);
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	f = fopen(tmp, "w");
+	if (!f)
+		die("can't create %s: %s", tmp, strerror(errno));
+	write_all(f, &hdr, sizeof(hdr));
+	write_all(f, disk_files, nr_files * sizeof(struct index_file));
+	write_all(f, sorted_tus, nr_tus * sizeof(struct index_tu));
+	write_all(f, sorted_deps, nr_deps * sizeof(uint32_t));
+	write_all(f, sorted_refs, nr_refs * sizeof(struct index_ref));
+	write_all(f, disk_owners, hdr.nr_owners * sizeof(uint32_t));
+	write_all(f, strings, strings_size);
+	if (fclose(f))
+		die("can't write %s: %s", tmp, strerror(errno));
+	if (rename(tmp, path) < 0)
+		die("can't rename %s: %s", tmp, strerror(errno));
+
+	free(sorted);
+	free(tu_order);
+	free(sorted_tus);
+	free(sorted_deps);
+	free(disk_files);
+	free(ref_order);
+	free(ref_map);
+	free(sorted_refs);
+	free(disk_owners);
+}
+
+static int parse_jobs(const char *arg)
+{
+	char *end;
+	long nr;
+
+	errno = 0;
+	nr = strtol(arg, &end, 10);
+	if (errno || end == arg || *end || nr < 1 || nr > INT_MAX)
+		die("-j needs a positive number, not '%s'", arg);
+	return nr;
+}
+
+static int build(int argc, char **argv)
+{
+	struct string_list *filelist = NULL;
+	const char *index = "sindex.idx";
+	int nr_jobs = 1;
+	const char *arg;
+	uint32_t idx;
+	char *file;
+	int used;
+
+	/* the sindex options come first, the rest is for sparse */
+	while (argc > 1) {
+		arg = argv[1];
+		used = 1;
+		if (!strncmp(arg, "-j", 2) || !strncmp(arg, "-o", 2)) {
+			if (arg[2]) {
+				arg += 2;
+			} else {
+				if (argc < 3)
+					die("%s needs an argument", arg);
+				arg = argv[2];
+				used = 2;
+			}
+			if (argv[1][1] == 'j')
+				nr_jobs = parse_jobs(arg);
+			else
+				index = arg;
+		} else if (!strcmp(arg, "-v")) {
+			show_files = 1;
+		} else {
+			break;
+		}
+		argv[used] = argv[0];
+		argc -= used;
+		argv += used;
+	}
+
+	sparse_initialize(argc, argv, &filelist);
+	FOR_EACH_PTR_NOTAG(filelist, file) {
+		idx = find_file(file);
+		files[idx].listed = 1;
+	} END_FOR_EACH_PTR_NOTAG(file);
+
+	load_old_index(index);
+	run_jobs(filelist, index, nr_jobs);
+	write_index(index);
+	return 0;
+}
+
+static void show_ref(struct index *idx, struct index_ref *ref)
+{
+	char mode[4];
+
+	if (ref->mode == (uint32_t)-1) {
+		strcpy(mode, "def");
+	} else {
+#define	U(u_r)	"-rwm"[(ref->mode / u_r) & 3]
+		mode[0] = U(U_R_AOF);
+		mode[1] = U(U_R_VAL);
+		mode[2] = U(U_R_PTR);
+		mode[3] = '\0';
+#undef	U
+	}
+	printf("%s:%u:%u %c %-3s %s\n", idx->strings + idx->files[ref->file].name,
+	       ref->line, ref->col, ref->storage, mode, idx->strings + ref->name);
+}
+
+static int search(int argc, char **argv)
+{
+	const char *index = "sindex.idx";
+	struct index idx;
+	struct index_ref *ref;
+	uint32_t lo, hi, mid;
+	const char *name;
+
+	if (argc > 3 && !strcmp(argv[1], "-i")) {
+		index = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc != 2)
+		die("usage: sindex search [-i <index>] <name>");
+	name = argv[1];
+
+	if (open_index(index, &idx) < 0)
+		die("can't read the index %s", index);
+
+	lo = 0;
+	hi = idx.hdr->nr_refs;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (strcmp(idx.strings + idx.refs[mid].name, name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < idx.hdr->nr_refs; lo++) {
+		ref = &idx.refs[lo];
+		if (strcmp(idx.strings + ref->name, name) != 0)
+			break;
+		show_ref(&idx, ref);
+	}
+	munmap(idx.map, idx.size);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "build"))
+		return build(argc - 1, argv + 1);
+	if (argc > 1 && !strcmp(argv[1], "search"))
+		return search(argc - 1, argv + 1);
+
+	fprintf(stderr, "usage: sindex build [-j <jobs>] [-o <index>] [-v] [sparse options] <files...>\n");
+	fprintf(stderr, "       sindex search [-i <index>] <name>\n");
+	return 1;
+}
@@ -15,10 +15,13 @@
  * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
  */
 
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <libgen.h>
 #include "smatch.h"
+#include "smatch_slist.h"
 #include "check_list.h"
 
 char *option_debug_check = (char *)"";
@@ -32,6 +35,7 @@ int option_full_path = 0;
 int option_param_mapper = 0;
 int option_call_tree = 0;
 int option_no_db = 0;
+int option_no_caller_summary = 0;
 int option_enable = 0;
 int option_debug_related;
 int option_file_output;
@@ -83,6 +87,21 @@ static void show_checks(void)
 	}
 	exit(1);
 }
+
+static int parse_positive(const char *option, const char *str)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(str, &end, 10);
+	if (end == str || *end || errno || val < 1 || val > INT_MAX) {
+		fprintf(stderr, "%s needs a positive number, not '%s'\n", option, str);
+		exit(1);
+	}
+	return val;
+}
+
 static void enable_check(int i)
 {
 	if (1 <= i && i < ARRAY_SIZE(reg_funcs))
@@ -125,14 +144,24 @@ static void help(void)
 	printf("--project=<name> or -p=<name>: project specific tests\n");
 	printf("--spammy:  print superfluous crap.\n");
 	printf("--info:  print info used to fill smatch_data/.\n");
+	printf("--info-frames=<file>:  append the --info SQL to <file> as compressed blocks.\n");
+	printf("--function-cache=<dir>:  reuse the output of functions which have not changed.\n");
 	printf("--debug:  print lots of debug output.\n");
 	printf("--param-mapper:  enable param_mapper output.\n");
 	printf("--no-data:  do not use the /smatch_data/ directory.\n");
+	printf("--no-caller-summary:  read every caller's caller_info instead of the merged summary.\n");
 	printf("--data=<dir>: overwrite path to default smatch data directory.\n");
 	printf("--full-path:  print the full pathname.\n");
 	printf("--debug-implied:  print debug output about implications.\n");
 	printf("--assume-loops:  assume loops always go through at least once.\n");
 	printf("--two-passes:  use a two pass system for each function.\n");
+	printf("--jobs=<n>:  analyse the functions in a file using <n> worker processes.\n");
+	printf("--function-range=<start>:<count>:  only analyse functions <start> to <start> + <count> - 1.\n");
+	printf("--function-shard=<n>/<total>:  only analyse the functions whose name hashes to <n>.\n");
+	printf("--mem-stats[=<n>]:  print allocator statistics and the <n> functions using the most memory.\n");
+	printf("--cost-stats:  print how long each function and file took.\n");
+	printf("--server:  read requests from stdin and analyse one function at a time for editors.\n");
+	printf("--max-possible=<n>:  merge states once there are <n> possible states (default 100).\n");
 	printf("--file-output:  instead of printing stdout, print to \"file.c.smatch_out\".\n");
 	printf("--help:  print this helpful message.\n");
 	exit(1);
@@ -201,6 +230,46 @@ void parse_args(int *argcp, char ***argvp)
 			(*argvp)[1] = (*argvp)[0];
 			found = 1;
 		}
+		if (!found && strncmp((*argvp)[1], "--info-frames=", 14) == 0) {
+			option_info_frames = (*argvp)[1] + 14;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strncmp((*argvp)[1], "--function-cache=", 17) == 0) {
+			option_function_cache = (*argvp)[1] + 17;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strncmp((*argvp)[1], "--function-range=", 17) == 0) {
+			option_function_range = (*argvp)[1] + 17;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strncmp((*argvp)[1], "--function-shard=", 17) == 0) {
+			option_function_shard = (*argvp)[1] + 17;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strncmp((*argvp)[1], "--jobs=", 7) == 0) {
+			option_jobs = parse_positive("--jobs", (*argvp)[1] + 7);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strcmp((*argvp)[1], "--mem-stats") == 0) {
+			option_mem_stats = 10;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strncmp((*argvp)[1], "--mem-stats=", 12) == 0) {
+			option_mem_stats = parse_positive("--mem-stats", (*argvp)[1] + 12);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && strncmp((*argvp)[1], "--max-possible=", 15) == 0) {
+			option_max_possible = parse_positive("--max-possible", (*argvp)[1] + 15);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
 		if (!found && strncmp((*argvp)[1], "--enable=", 9) == 0) {
 			enable_checks((*argvp)[1] + 9);
 			option_enable = 1;
@@ -222,6 +291,9 @@ void parse_args(int *argcp, char ***argvp)
 		OPTION(file_output);
 		OPTION(time);
 		OPTION(no_db);
+		OPTION(no_caller_summary);
+		OPTION(cost_stats);
+		OPTION(server);
 		if (!found)
 			break;
 		(*argcp)--;
@@ -288,6 +360,7 @@ int main(int argc, char **argv)
 	sm_outfd = stdout;
 	sql_outfd = stdout;
 	caller_info_fd = stdout;
+	function_cache_args(argc, argv);
 	parse_args(&argc, &argv);
 
 	/* this gets set back to zero when we parse the first function */
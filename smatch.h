@@ -76,6 +76,7 @@ struct sm_state {
 	unsigned short merged:1;
 	unsigned int nr_children;
 	unsigned int line;
+	unsigned int nr_possible;
   	struct smatch_state *state;
 	struct stree *pool;
 	struct sm_state *left;
@@ -434,7 +435,10 @@ void __split_stmt(struct statement *stmt);
 extern int __in_function_def;
 extern int option_assume_loops;
 extern int option_two_passes;
+extern int option_jobs;
+void run_functions_serially(void);
 extern int option_no_db;
+extern int option_no_caller_summary;
 extern int option_file_output;
 extern int option_time;
 extern struct expression_list *big_expression_stack;
@@ -569,6 +573,65 @@ char *map_long_to_short_name_sym_nostack(const char *name, struct symbol *sym, s
 int get_absolute_min_helper(struct expression *expr, sval_t *sval);
 int get_absolute_max_helper(struct expression *expr, sval_t *sval);
 
+/* smatch_info_frames.c */
+extern char *option_info_frames;
+void info_frames_sql(const char *table, int ignore, const char *fmt, ...);
+void info_frames_caller_info(const char *fmt, ...);
+void info_frames_flush(void);
+
+/* smatch_function_cache.c */
+extern char *option_function_cache;
+struct cache_hash {
+	unsigned long long a, b;
+};
+void cache_hash_init(struct cache_hash *hash);
+void cache_hash_bytes(struct cache_hash *hash, const void *data, size_t len);
+void cache_hash_str(struct cache_hash *hash, const char *str);
+void cache_hash_row(struct cache_hash *hash, int argc, char **argv);
+void function_cache_args(int argc, char **argv);
+void function_cache_init(void);
+void function_cache_start_file(struct symbol_list *sym_list);
+int function_cache_replay(struct symbol *sym, char **buf, size_t *size, int nr,
+			  struct position *end_pos);
+void function_cache_start(struct symbol *sym);
+void function_cache_end(struct symbol *sym, char **buf, size_t *size, int nr,
+			struct position end_pos);
+int function_cache_recording(void);
+void function_cache_add_query(const char *sql, struct cache_hash *hash);
+void function_cache_sticky(int on);
+void function_cache_uncacheable(void);
+void function_cache_inline_call(struct symbol *sym);
+void function_cache_print_stats(void);
+
+/* smatch_mem_stats.c */
+extern int option_mem_stats;
+void mem_stats_start_function(void);
+void mem_stats_end_function(void);
+void mem_stats_end_file(void);
+void mem_stats_db_cache(const char *table, int rows, unsigned long bytes,
+			struct timeval *start);
+
+/* smatch_flow.c */
+extern char *option_function_range;
+extern char *option_function_shard;
+int function_shard_mode(void);
+void parse_function_shard_options(void);
+
+/* smatch_server.c */
+extern int option_server;
+void server_main(void);
+void server_start_file(struct symbol_list *sym_list);
+int server_wants_function(struct symbol *sym);
+int server_checks_whole_file(void);
+void smatch_check_file(char *filename, int fd);
+
+/* smatch_cost_stats.c */
+extern int option_cost_stats;
+void cost_stats_start_function(void);
+void cost_stats_implied(struct timeval *start);
+void cost_stats_end_function(void);
+void cost_stats_end_file(struct timeval *start, struct timeval *parsed);
+
 /* smatch_local_values.c */
 int get_local_rl(struct expression *expr, struct range_list **rl);
 int get_local_max_helper(struct expression *expr, sval_t *sval);
@@ -741,6 +804,9 @@ enum info_type {
 	SIZEOF_ARG	= 8034,
 };
 
+/* the DB hooks are dispatched through tables indexed by info_type */
+#define INFO_TYPE_MAX 10000
+
 void debug_sql(const char *sql);
 void debug_mem_sql(const char *sql);
 void select_caller_info_hook(void (*callback)(const char *name, struct symbol *sym, char *key, char *value), int type);
@@ -807,6 +873,9 @@ void sql_select_call_implies(const char *cols, struct expression *call,
 
 void sql_exec(int (*callback)(void*, int, char**, char**), void *data, const char *sql);
 void sql_mem_exec(int (*callback)(void*, int, char**, char**), void *data, const char *sql);
+void sql_hash_rows(const char *sql, struct cache_hash *hash);
+int get_return_id(void);
+void set_return_id(int id);
 
 void open_smatch_db(void);
 
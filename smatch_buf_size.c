@@ -206,8 +206,71 @@ static int db_size_callback(void *unused, int argc, char **argv, char **azColNam
 	return 0;
 }
 
+/*
+ * The type_size table and the BUF_SIZE rows of the extern data_info are
+ * small and looked up all the time so they are read in once, with the rows
+ * for each name already parsed and merged.
+ */
+static DEFINE_HASHTABLE_INSERT(insert_size, char, struct range_list);
+static DEFINE_HASHTABLE_SEARCH(search_size, char, struct range_list);
+static DEFINE_HASHTABLE_REMOVE(remove_size, char, struct range_list);
+static struct hashtable *type_size_cache;
+static struct hashtable *extern_size_cache;
+static int size_cache_rows;
+static unsigned long size_cache_bytes;
+
+static int load_size_callback(void *_table, int argc, char **argv, char **azColName)
+{
+	struct hashtable *table = _table;
+	struct range_list *rl, *old;
+	char *key;
+
+	str_to_rl(&int_ctype, argv[1], &rl);
+	if (!rl)
+		return 0;
+
+	old = remove_size(table, argv[0]);
+	if (old) {
+		rl = rl_union(old, rl);
+	} else {
+		size_cache_rows++;
+		size_cache_bytes += strlen(argv[0]) + 1;
+	}
+	key = alloc_string(argv[0]);
+	rl = clone_rl_permanent(rl);
+	size_cache_bytes += ptr_list_size((struct ptr_list *)rl) * sizeof(struct data_range);
+	insert_size(table, key, rl);
+	return 0;
+}
+
+static void load_size_caches(void)
+{
+	struct timeval start;
+
+	if (type_size_cache)
+		return;
+
+	gettimeofday(&start, NULL);
+	type_size_cache = create_function_hashtable(4000);
+	function_cache_sticky(1);
+	run_sql(load_size_callback, type_size_cache,
+		"select type, size from type_size;");
+	mem_stats_db_cache("type_size", size_cache_rows, size_cache_bytes, &start);
+
+	size_cache_rows = 0;
+	size_cache_bytes = 0;
+	gettimeofday(&start, NULL);
+	extern_size_cache = create_function_hashtable(1000);
+	run_sql(load_size_callback, extern_size_cache,
+		"select data, value from data_info where file = 'extern' and type = %d;",
+		BUF_SIZE);
+	function_cache_sticky(0);
+	mem_stats_db_cache("data_info extern", size_cache_rows, size_cache_bytes, &start);
+}
+
 static struct range_list *size_from_db_type(struct expression *expr)
 {
+	struct range_list *rl;
 	int this_file_only = 0;
 	char *name;
 
@@ -229,11 +292,10 @@ static struct range_list *size_from_db_type(struct expression *expr)
 		return NULL;
 	}
 
-	db_size_rl = NULL;
-	run_sql(db_size_callback, NULL,
-		"select size from type_size where type = '%s';",
-		name);
-	return db_size_rl;
+	load_size_caches();
+	rl = search_size(type_size_cache, name);
+	free_string(name);
+	return clone_rl(rl);
 }
 
 static struct range_list *size_from_db_symbol(struct expression *expr)
@@ -248,11 +310,8 @@ static struct range_list *size_from_db_symbol(struct expression *expr)
 	    sym->ctype.modifiers & MOD_STATIC)
 		return NULL;
 
-	db_size_rl = NULL;
-	run_sql(db_size_callback, NULL,
-		"select value from data_info where file = 'extern' and data = '%s' and type = %d;",
-		sym->ident->name, BUF_SIZE);
-	return db_size_rl;
+	load_size_caches();
+	return clone_rl(search_size(extern_size_cache, sym->ident->name));
 }
 
 static struct range_list *size_from_db(struct expression *expr)
@@ -41,7 +41,7 @@ static int inc_dec_link_id;
 STATE(start);
 STATE(incremented);
 
-ALLOCATOR(compare_data, "compare data");
+ARENA_ALLOCATOR(compare_data, "compare data", &function_arena);
 
 static struct symbol *vsl_to_sym(struct var_sym_list *vsl)
 {
@@ -2076,20 +2076,12 @@ free:
 	return ret;
 }
 
-static void free_data(struct symbol *sym)
-{
-	if (__inline_fn)
-		return;
-	clear_compare_data_alloc();
-}
-
 void register_comparison(int id)
 {
 	compare_id = id;
 	add_hook(&save_start_states, AFTER_DEF_HOOK);
 	add_unmatched_state_hook(compare_id, unmatched_comparison);
 	add_merge_hook(compare_id, &merge_compare_states);
-	add_hook(&free_data, AFTER_FUNC_HOOK);
 	add_hook(&match_call_info, FUNCTION_CALL_HOOK);
 	add_split_return_callback(&print_return_comparison);
 
@@ -44,6 +44,7 @@
 #include "smatch.h"
 #include "smatch_extra.h"
 #include "smatch_slist.h"
+#include "smatch_function_hashtable.h"
 
 static int my_id;
 
@@ -126,7 +127,7 @@ static struct smatch_state *alloc_constraint_state(struct constraint_list *list)
 	} END_FOR_EACH_PTR(con);
 
 	state = __alloc_smatch_state(0);
-	state->name = alloc_string(buf);
+	state->name = alloc_sname(buf);
 	state->data = list;
 	return state;
 }
@@ -187,40 +188,81 @@ char *get_constraint_str(struct expression *expr)
 	return get_member_name(expr);
 }
 
-static int save_int_callback(void *_p, int argc, char **argv, char **azColName)
+/*
+ * The constraints table is small and every comparison looks something up
+ * in it so it's read in once.  "constraint_ids" maps the string to the id
+ * and "constraint_strs" is indexed by id.
+ */
+static DEFINE_HASHTABLE_INSERT(insert_constraint_id, char, int);
+static DEFINE_HASHTABLE_SEARCH(search_constraint_id, char, int);
+static struct hashtable *constraint_ids;
+static char **constraint_strs;
+static int nr_constraint_strs;
+
+static int load_constraint_callback(void *_bytes, int argc, char **argv, char **azColName)
 {
-	int *p = _p;
+	unsigned long *bytes = _bytes;
+	int id = atoi(argv[0]);
+	char *str;
+
+	if (id < 0)
+		return 0;
+
+	if (id >= nr_constraint_strs) {
+		int size = nr_constraint_strs ? nr_constraint_strs : 256;
+
+		while (size <= id)
+			size *= 2;
+		constraint_strs = realloc(constraint_strs, size * sizeof(*constraint_strs));
+		memset(constraint_strs + nr_constraint_strs, 0,
+		       (size - nr_constraint_strs) * sizeof(*constraint_strs));
+		*bytes += (size - nr_constraint_strs) * sizeof(*constraint_strs);
+		nr_constraint_strs = size;
+	}
 
-	*p = atoi(argv[0]);
+	str = alloc_string(argv[1]);
+	free_string(constraint_strs[id]);
+	constraint_strs[id] = str;
+	/* the ids are stored +1 so that id 0 isn't a NULL pointer */
+	insert_constraint_id(constraint_ids, alloc_string(argv[1]), INT_PTR(id + 1));
+	*bytes += 2 * (strlen(argv[1]) + 1);
 	return 0;
 }
 
-static int constraint_str_to_id(const char *str)
+static void load_constraints(void)
 {
-	int id = -1;
+	struct timeval start;
+	unsigned long bytes = 0;
 
-	run_sql(save_int_callback, &id,
-		"select id from constraints where str = '%s'", str);
+	if (constraint_ids)
+		return;
 
-	return id;
+	gettimeofday(&start, NULL);
+	constraint_ids = create_function_hashtable(1000);
+	function_cache_sticky(1);
+	run_sql(load_constraint_callback, &bytes,
+		"select id, str from constraints;");
+	function_cache_sticky(0);
+	mem_stats_db_cache("constraints", hashtable_count(constraint_ids), bytes, &start);
 }
 
-static int save_constraint_str(void *_str, int argc, char **argv, char **azColName)
+static int constraint_str_to_id(const char *str)
 {
-	char **str = _str;
+	int *id;
 
-	*str = alloc_string(argv[0]);
-	return 0;
+	load_constraints();
+	id = search_constraint_id(constraint_ids, (char *)str);
+	if (!id)
+		return -1;
+	return PTR_INT(id) - 1;
 }
 
 static char *constraint_id_to_str(int id)
 {
-	char *str = NULL;
-
-	run_sql(save_constraint_str, &str,
-		"select str from constraints where id = '%d'", id);
-
-	return str;
+	load_constraints();
+	if (id < 0 || id >= nr_constraint_strs)
+		return NULL;
+	return alloc_string(constraint_strs[id]);
 }
 
 static int save_op_callback(void *_p, int argc, char **argv, char **azColName)
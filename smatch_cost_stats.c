@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * The --cost-stats option prints how long each function and each file took
+ * so the next run can start the slow files first.  The format is the same
+ * as --mem-stats:
+ *
+ * cost: function|file|func|usecs|sm_states|implied_usecs
+ * cost: file|file|usecs|parse_usecs
+ *
+ * "sm_states" is how many sm_states the function allocated and
+ * "implied_usecs" is how much of the time was spent in smatch_implied.c.
+ * The file "usecs" is the wall time for the whole file including
+ * "parse_usecs" which is the time to preprocess and parse it.  It doesn't
+ * include the time to start smatch and load the hooks.
+ *
+ * smatch_scripts/cost_schedule.py reads these lines.
+ */
+
+#include "smatch.h"
+#include "smatch_slist.h"
+
+int option_cost_stats;
+
+static struct timeval fn_start;
+static unsigned long long implied_usecs;
+
+static long long usecs_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000LL +
+	       (now.tv_usec - start->tv_usec);
+}
+
+void cost_stats_start_function(void)
+{
+	if (!option_cost_stats)
+		return;
+
+	implied_usecs = 0;
+	gettimeofday(&fn_start, NULL);
+}
+
+void cost_stats_implied(struct timeval *start)
+{
+	if (!option_cost_stats)
+		return;
+
+	implied_usecs += usecs_since(start);
+}
+
+void cost_stats_end_function(void)
+{
+	const char *func;
+
+	if (!option_cost_stats)
+		return;
+
+	func = get_function();
+	if (!func)
+		func = "unknown";
+
+	fprintf(sm_outfd, "cost: function|%s|%s|%lld|%d|%llu\n",
+		get_base_file(), func, usecs_since(&fn_start),
+		get_sm_state_count(), implied_usecs);
+}
+
+void cost_stats_end_file(struct timeval *start, struct timeval *parsed)
+{
+	if (!option_cost_stats)
+		return;
+
+	fprintf(sm_outfd, "cost: file|%s|%lld|%lld\n",
+		get_base_file(), usecs_since(start),
+		(parsed->tv_sec - start->tv_sec) * 1000000LL +
+		(parsed->tv_usec - start->tv_usec));
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+#
+# Fills the caller_info_summary table from caller_info.  This has to run
+# after everything else which changes caller_info.
+#
+# When smatch starts a function it runs the caller_info rows of every caller
+# into a fake stree and then merges them all together.  A lot of callers pass
+# exactly the same thing and merging a stree with a copy of itself doesn't
+# change anything, so the summary only keeps the first of each set of
+# identical callers.  The rows keep their call_id and their order so smatch
+# reads them the same way it reads caller_info.
+#
+
+db_file=$1
+bin_dir=$(dirname $0)
+
+if [[ "$db_file" = "" ]] ; then
+    echo "Usage:  $0 <db_file>"
+    exit 1
+fi
+
+( echo "DROP TABLE IF EXISTS caller_info_summary;"
+  cat ${bin_dir}/caller_info_summary.schema
+  cat << EOF
+PRAGMA synchronous = OFF;
+PRAGMA cache_size = 800000;
+PRAGMA journal_mode = OFF;
+PRAGMA count_changes = OFF;
+PRAGMA temp_store = MEMORY;
+PRAGMA locking = EXCLUSIVE;
+
+-- the rows of each caller in the order smatch reads them.  quote() puts
+-- the strings in quotes and doubles the quotes inside them so a '|' or a
+-- newline in a key or a value can't make two callers look the same.
+CREATE TEMP TABLE ci_callers AS
+SELECT call_id, function, static,
+       CASE WHEN static = 1 THEN file ELSE '' END AS sfile,
+       group_concat(quote(type) || ',' || quote(parameter) || ',' ||
+                    quote(key) || ',' || quote(value), ',') AS rows
+FROM (SELECT * FROM caller_info ORDER BY call_id, rowid)
+GROUP BY call_id;
+
+CREATE TEMP TABLE ci_keep AS
+SELECT min(call_id) AS call_id FROM ci_callers
+GROUP BY function, static, sfile, rows;
+CREATE INDEX ci_keep_idx ON ci_keep (call_id);
+
+INSERT INTO caller_info_summary
+SELECT file, caller, function, call_id, static, type, parameter, key, value
+FROM caller_info
+WHERE call_id IN (SELECT call_id FROM ci_keep)
+ORDER BY call_id, rowid;
+
+CREATE INDEX caller_summary_fn_idx on caller_info_summary (function, call_id);
+CREATE INDEX caller_summary_ff_idx on caller_info_summary (file, function, call_id);
+EOF
+) | sqlite3 $db_file
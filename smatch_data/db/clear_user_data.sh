@@ -1,5 +1,5 @@
 #!/bin/bash
 
-echo "delete from caller_info where type = 8017; delete from return_states where type = 8017;" | sqlite3 smatch_db.sqlite
+echo "delete from caller_info where type = 8017; delete from caller_info_summary where type = 8017; delete from return_states where type = 8017;" | sqlite3 smatch_db.sqlite
 
 
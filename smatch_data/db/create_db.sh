@@ -21,16 +21,30 @@ for i in ${bin_dir}/*.schema ; do
     cat $i | sqlite3 $db_file
 done
 
+# the SQL from --info-frames=${info_file}.frames
+frames_file=""
+if [ -e ${info_file}.frames ] ; then
+    frames_file=$(mktemp)
+    ${bin_dir}/decode_info_frames.py ${info_file}.frames > $frames_file
+fi
+
 ${bin_dir}/init_constraints.pl "$PROJ" $info_file $db_file
 ${bin_dir}/init_constraints_required.pl "$PROJ" $info_file $db_file
 ${bin_dir}/fill_db_sql.pl "$PROJ" $info_file $db_file
 if [ -e ${info_file}.sql ] ; then
     ${bin_dir}/fill_db_sql.pl "$PROJ" ${info_file}.sql $db_file
 fi
+if [ "$frames_file" != "" ] ; then
+    ${bin_dir}/fill_db_sql.pl "$PROJ" $frames_file $db_file
+fi
 ${bin_dir}/fill_db_caller_info.pl "$PROJ" $info_file $db_file
 if [ -e ${info_file}.caller_info ] ; then
     ${bin_dir}/fill_db_caller_info.pl "$PROJ" ${info_file}.caller_info $db_file
 fi
+if [ "$frames_file" != "" ] ; then
+    ${bin_dir}/fill_db_caller_info.pl "$PROJ" $frames_file $db_file
+    rm $frames_file
+fi
 ${bin_dir}/build_early_index.sh $db_file
 
 ${bin_dir}/fill_db_type_value.pl "$PROJ" $info_file $db_file
@@ -55,4 +69,6 @@ while read func old new ; do
     echo "update return_states set return = '$new' where function = '$func' and return = '$old';" | sqlite3 $db_file
 done
 
+${bin_dir}/build_caller_info_summary.sh $db_file
+
 mv $db_file smatch_db.sqlite
@@ -0,0 +1,95 @@
+#!/usr/bin/python3
+
+#
+# Prints a file written by "smatch --info --info-frames=<file>" as the
+# "SQL:" and "SQL_caller_info:" lines that --info normally prints so the
+# other scripts in this directory can read it.  See smatch_info_frames.c
+# for the format.
+#
+
+import struct
+import sys
+import zlib
+
+FILE_FUNC_MARK = 1
+
+def read_varint(data, pos):
+    val = 0
+    shift = 0
+    while True:
+        c = data[pos]
+        pos += 1
+        val |= (c & 0x7f) << shift
+        if not c & 0x80:
+            return val, pos
+        shift += 7
+
+def read_string(data, pos):
+    end = data.index(b'\0', pos)
+    return data[pos:end].decode('utf-8', 'surrogateescape'), end + 1
+
+def decode_block(data, out):
+    pos = 0
+    file_name = func = prefix = ""
+    while pos < len(data):
+        kind = chr(data[pos])
+        pos += 1
+        if kind == 'F':
+            file_name, pos = read_string(data, pos)
+            func, pos = read_string(data, pos)
+            prefix = "'%s', '%s'" % (file_name, func)
+            continue
+
+        line, pos = read_varint(data, pos)
+        if kind in "SI":
+            table, pos = read_string(data, pos)
+        if data[pos] == FILE_FUNC_MARK:
+            values, pos = read_string(data, pos + 1)
+            values = prefix + values
+        else:
+            values, pos = read_string(data, pos)
+
+        if kind == 'S':
+            sql = "SQL: insert into %s values(%s);" % (table, values)
+        elif kind == 'I':
+            sql = "SQL: insert or ignore into %s values(%s);" % (table, values)
+        elif kind == 'C':
+            sql = "SQL_caller_info: insert into caller_info values (%s);" % values
+        else:
+            sys.stderr.write("unknown record type '%s'\n" % kind)
+            return
+        out.write("%s:%d %s() %s\n" % (file_name, line, func, sql))
+
+def decode_file(name, out):
+    with open(name, "rb") as f:
+        while True:
+            header = f.read(16)
+            if not header:
+                break
+            if len(header) != 16 or header[0:4] != b"SMIF":
+                sys.stderr.write("%s: bad block header\n" % name)
+                return 1
+            flags, raw_len, length = struct.unpack("<III", header[4:])
+            data = f.read(length)
+            if len(data) != length:
+                sys.stderr.write("%s: truncated block\n" % name)
+                return 1
+            if flags & 1:
+                data = zlib.decompress(data)
+            if len(data) != raw_len:
+                sys.stderr.write("%s: bad block length\n" % name)
+                return 1
+            decode_block(data, out)
+    return 0
+
+if len(sys.argv) < 2:
+    print("Usage:  %s <frames file>..." % sys.argv[0])
+    sys.exit(1)
+
+out = open(sys.stdout.fileno(), "w", encoding="utf-8",
+           errors="surrogateescape", closefd=False)
+ret = 0
+for name in sys.argv[1:]:
+    ret |= decode_file(name, out)
+out.flush()
+sys.exit(ret)
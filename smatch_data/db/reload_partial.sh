@@ -15,6 +15,14 @@ fi
 bin_dir=$(dirname $0)
 db_file=smatch_db.sqlite
 
+# a file from --info-frames has to be turned back into text first
+frames_file=""
+if [ "$(head -c 4 $info_file)" = "SMIF" ] ; then
+    frames_file=$(mktemp)
+    ${bin_dir}/decode_info_frames.py $info_file > $frames_file
+    info_file=$frames_file
+fi
+
 files=$(grep "insert into caller_info" $info_file | cut -d : -f 1 | sort -u)
 for c_file in $files; do
     echo "FILE $c_file"
@@ -35,9 +43,14 @@ grep "insert into call_implies" $info_file > $tmp_file
 ${bin_dir}/fill_db_sql.pl "$PROJ" $tmp_file $db_file
 
 rm $tmp_file
+if [ "$frames_file" != "" ] ; then
+    rm $frames_file
+fi
 
 ${bin_dir}/fixup_all.sh $db_file
 if [ "$PROJ" != "" ] ; then
     ${bin_dir}/fixup_${PROJ}.sh $db_file
 fi
 
+${bin_dir}/build_caller_info_summary.sh $db_file
+
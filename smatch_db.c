@@ -29,6 +29,17 @@ static sqlite3 *mem_db;
 
 static int return_id;
 
+/* --function-cache skips functions so it has to keep the count in step */
+int get_return_id(void)
+{
+	return return_id;
+}
+
+void set_return_id(int id)
+{
+	return_id = id;
+}
+
 #define sql_insert_helper(table, ignore, values...)				\
 do {										\
 	if (__inline_fn) {							\
@@ -53,6 +64,10 @@ do {										\
 		}								\
 		break;								\
 	}									\
+	if (option_info && option_info_frames) {				\
+		info_frames_sql(#table, ignore, values);			\
+		break;								\
+	}									\
 	if (option_info) {							\
 		FILE *tmp_fd = sm_outfd;					\
 		sm_outfd = sql_outfd;						\
@@ -74,7 +89,7 @@ struct def_callback {
 };
 ALLOCATOR(def_callback, "definition db hook callbacks");
 DECLARE_PTR_LIST(callback_list, struct def_callback);
-static struct callback_list *select_caller_info_callbacks;
+static struct callback_list *select_caller_info_callbacks[INFO_TYPE_MAX];
 
 struct member_info_callback {
 	int owner;
@@ -105,7 +120,7 @@ struct call_implies_callback {
 };
 ALLOCATOR(call_implies_callback, "call_implies callbacks");
 DECLARE_PTR_LIST(call_implies_cb_list, struct call_implies_callback);
-static struct call_implies_cb_list *call_implies_cb_list;
+static struct call_implies_cb_list *call_implies_cb_list[INFO_TYPE_MAX];
 
 static int print_sql_output(void *unused, int argc, char **argv, char **azColName)
 {
@@ -136,6 +151,59 @@ void debug_mem_sql(const char *sql)
 	sql_mem_exec(print_sql_output, NULL, sql);
 }
 
+struct cache_exec_info {
+	int (*callback)(void*, int, char**, char**);
+	void *data;
+	struct cache_hash hash;
+};
+
+static int cache_exec_callback(void *_info, int argc, char **argv, char **azColName)
+{
+	struct cache_exec_info *info = _info;
+
+	cache_hash_row(&info->hash, argc, argv);
+	if (!info->callback)
+		return 0;
+	return info->callback(info->data, argc, argv, azColName);
+}
+
+static int hash_rows_callback(void *hash, int argc, char **argv, char **azColName)
+{
+	cache_hash_row(hash, argc, argv);
+	return 0;
+}
+
+void sql_hash_rows(const char *sql, struct cache_hash *hash)
+{
+	if (option_no_db || !db)
+		return;
+	sqlite3_exec(db, sql, hash_rows_callback, hash, NULL);
+}
+
+/*
+ * With --function-cache the rows are hashed on the way through so the saved
+ * output can be thrown away if the DB changes.
+ */
+static int sql_exec_recorded(int (*callback)(void*, int, char**, char**), void *data,
+			     const char *sql, char **err)
+{
+	struct cache_exec_info info = {
+		.callback = callback,
+		.data = data,
+	};
+	int rc;
+
+	cache_hash_init(&info.hash);
+	rc = sqlite3_exec(db, sql, cache_exec_callback, &info, err);
+	if (rc == SQLITE_ABORT) {
+		/* the callback stopped early so hash the rest as well */
+		cache_hash_init(&info.hash);
+		sql_hash_rows(sql, &info.hash);
+	}
+	function_cache_add_query(sql, &info.hash);
+	return rc;
+}
+
 void sql_exec(int (*callback)(void*, int, char**, char**), void *data, const char *sql)
 {
 	char *err = NULL;
@@ -144,7 +212,10 @@ void sql_exec(int (*callback)(void*, int, char**, char**), void *data, const cha
 	if (option_no_db || !db)
 		return;
 
-	rc = sqlite3_exec(db, sql, callback, data, &err);
+	if (function_cache_recording())
+		rc = sql_exec_recorded(callback, data, sql, &err);
+	else
+		rc = sqlite3_exec(db, sql, callback, data, &err);
 	if (rc != SQLITE_OK && !parse_error) {
 		fprintf(stderr, "SQL error #2: %s\n", err);
 		fprintf(stderr, "SQL: '%s'\n", sql);
@@ -253,6 +324,14 @@ void sql_insert_caller_info(struct expression *call, int type,
 	if (type != INTERNAL && is_common_function(fn))
 		return;
 
+	if (option_info_frames) {
+		info_frames_caller_info("'%s', '%s', '%s', %%CALL_ID%%, %d, %d, %d, '%s', '%s'",
+					get_base_file(), get_function(), fn,
+					is_static(call->fn), type, param, key, value);
+		free_string(fn);
+		return;
+	}
+
 	sm_outfd = caller_info_fd;
 	sm_msg("SQL_caller_info: insert into caller_info values ("
 	       "'%s', '%s', '%s', %%CALL_ID%%, %d, %d, %d, '%s', '%s');",
@@ -461,6 +540,56 @@ void sql_select_return_states(const char *cols, struct expression *call,
 		cols, get_static_filter(call->fn->symbol));
 }
 
+/*
+ * Only ask for the rows that some hook wants.  The INTERNAL rows are always
+ * selected because they mark where each caller starts.
+ */
+static void build_type_filter(char *buf, int size, struct ptr_list **hooks)
+{
+	int type;
+	int pos;
+
+	pos = snprintf(buf, size, "type in (%d", INTERNAL);
+	for (type = INTERNAL + 1; type < INFO_TYPE_MAX; type++) {
+		if (!hooks[type])
+			continue;
+		pos += snprintf(buf + pos, size - pos, ", %d", type);
+		if (pos >= size - 1) {
+			snprintf(buf, size, "1");
+			return;
+		}
+	}
+	snprintf(buf + pos, size - pos, ")");
+}
+
+static const char *caller_info_type_filter(void)
+{
+	static char filter[256];
+
+	if (!filter[0])
+		build_type_filter(filter, sizeof(filter),
+				  (struct ptr_list **)select_caller_info_callbacks);
+	return filter;
+}
+
+static const char *call_implies_type_filter(void)
+{
+	static char filter[256];
+
+	if (!filter[0])
+		build_type_filter(filter, sizeof(filter),
+				  (struct ptr_list **)call_implies_cb_list);
+	return filter;
+}
+
+static void check_info_type(int type)
+{
+	if (type < 0 || type >= INFO_TYPE_MAX) {
+		printf("FATAL ERROR: info type %d is out of range\n", type);
+		exit(1);
+	}
+}
+
 void sql_select_call_implies(const char *cols, struct expression *call,
 	int (*callback)(void*, int, char**, char**))
 {
@@ -469,13 +598,14 @@ void sql_select_call_implies(const char *cols, struct expression *call,
 
 	if (inlinable(call->fn)) {
 		mem_sql(callback, call,
-			"select %s from call_implies where call_id = '%lu';",
-			cols, (unsigned long)call);
+			"select %s from call_implies where call_id = '%lu' and %s;",
+			cols, (unsigned long)call, call_implies_type_filter());
 		return;
 	}
 
-	run_sql(callback, call, "select %s from call_implies where %s;",
-		cols, get_static_filter(call->fn->symbol));
+	run_sql(callback, call, "select %s from call_implies where %s and %s;",
+		cols, get_static_filter(call->fn->symbol),
+		call_implies_type_filter());
 }
 
 struct select_caller_info_data {
@@ -485,37 +615,60 @@ struct select_caller_info_data {
 	int results;
 };
 
+/*
+ * caller_info_summary has the same columns as caller_info but the callers
+ * are collapsed into as few groups as give the same states after merging.
+ * It's made by build_caller_info_summary.sh and older DBs don't have it.
+ */
+static const char *caller_info_table(void)
+{
+	static int have_summary = -1;
+
+	if (have_summary == -1) {
+		have_summary = 0;
+		function_cache_sticky(1);
+		run_sql(get_row_count, &have_summary,
+			"select count(*) from sqlite_master where type = 'table' and name = 'caller_info_summary';");
+		function_cache_sticky(0);
+	}
+	if (have_summary && !option_no_caller_summary)
+		return "caller_info_summary";
+	return "caller_info";
+}
+
 static void sql_select_caller_info(struct select_caller_info_data *data,
 	const char *cols, struct symbol *sym,
 	int (*callback)(void*, int, char**, char**))
 {
 	if (__inline_fn) {
 		mem_sql(callback, data,
-			"select %s from caller_info where call_id = %lu;",
-			cols, (unsigned long)__inline_fn);
+			"select %s from caller_info where call_id = %lu and %s;",
+			cols, (unsigned long)__inline_fn, caller_info_type_filter());
 		return;
 	}
 
 	if (sym->ident->name && is_common_function(sym->ident->name))
 		return;
 	run_sql(callback, data,
-		"select %s from common_caller_info where %s order by call_id;",
-		cols, get_static_filter(sym));
+		"select %s from common_caller_info where %s and %s order by call_id;",
+		cols, get_static_filter(sym), caller_info_type_filter());
 	if (data->results)
 		return;
 
 	run_sql(callback, data,
-		"select %s from caller_info where %s order by call_id;",
-		cols, get_static_filter(sym));
+		"select %s from %s where %s and %s order by call_id;",
+		cols, caller_info_table(), get_static_filter(sym),
+		caller_info_type_filter());
 }
 
 void select_caller_info_hook(void (*callback)(const char *name, struct symbol *sym, char *key, char *value), int type)
 {
 	struct def_callback *def_callback = __alloc_def_callback(0);
 
+	check_info_type(type);
 	def_callback->hook_type = type;
 	def_callback->callback = callback;
-	add_ptr_list(&select_caller_info_callbacks, def_callback);
+	add_ptr_list(&select_caller_info_callbacks[type], def_callback);
 }
 
 /*
@@ -553,9 +706,10 @@ void select_call_implies_hook(int type, void (*callback)(struct expression *call
 {
 	struct call_implies_callback *cb = __alloc_call_implies_callback(0);
 
+	check_info_type(type);
 	cb->type = type;
 	cb->callback = callback;
-	add_ptr_list(&call_implies_cb_list, cb);
+	add_ptr_list(&call_implies_cb_list[type], cb);
 }
 
 struct return_info {
@@ -877,9 +1031,10 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 	if (param >= 0 && !get_param(param, &name, &sym))
 		return 0;
 
-	FOR_EACH_PTR(select_caller_info_callbacks, def_callback) {
-		if (def_callback->hook_type == type)
-			def_callback->callback(name, sym, key, value);
+	if (type < 0 || type >= INFO_TYPE_MAX)
+		return 0;
+	FOR_EACH_PTR(select_caller_info_callbacks[type], def_callback) {
+		def_callback->callback(name, sym, key, value);
 	} END_FOR_EACH_PTR(def_callback);
 
 	return 0;
@@ -982,8 +1137,8 @@ static void match_data_from_db(struct symbol *sym)
 		FOR_EACH_PTR(ptr_names, ptr) {
 			run_sql(caller_info_callback, &data,
 				"select call_id, type, parameter, key, value"
-				" from common_caller_info where function = '%s' order by call_id",
-				ptr);
+				" from common_caller_info where function = '%s' and %s order by call_id",
+				ptr, caller_info_type_filter());
 		} END_FOR_EACH_PTR(ptr);
 
 		if (data.results) {
@@ -996,8 +1151,8 @@ static void match_data_from_db(struct symbol *sym)
 		FOR_EACH_PTR(ptr_names, ptr) {
 			run_sql(caller_info_callback, &data,
 				"select call_id, type, parameter, key, value"
-				" from caller_info where function = '%s' order by call_id",
-				ptr);
+				" from %s where function = '%s' and %s order by call_id",
+				caller_info_table(), ptr, caller_info_type_filter());
 			free_string(ptr);
 		} END_FOR_EACH_PTR(ptr);
 
@@ -1033,10 +1188,10 @@ static int call_implies_callbacks(void *_call, int argc, char **argv, char **azC
 
 	type = atoi(argv[1]);
 	param = atoi(argv[2]);
+	if (type < 0 || type >= INFO_TYPE_MAX)
+		return 0;
 
-	FOR_EACH_PTR(call_implies_cb_list, cb) {
-		if (cb->type != type)
-			continue;
+	FOR_EACH_PTR(call_implies_cb_list[type], cb) {
 		if (param != -1) {
 			arg = get_argument_from_call_expr(call_expr->args, param);
 			if (!arg)
@@ -1258,7 +1413,7 @@ static int split_possible_helper(struct sm_state *sm, struct expression *expr)
 		return 0;
 
 	/* bail if it gets too complicated */
-	nr_possible = ptr_list_size((struct ptr_list *)sm->possible);
+	nr_possible = sm->nr_possible;
 	nr_states = stree_count(__get_cur_stree());
 	if (nr_states * nr_possible >= 2000)
 		return 0;
@@ -1645,7 +1800,7 @@ static int split_on_bool_sm(struct sm_state *sm, struct expression *expr)
 		return 0;
 
 	/* bail if it gets too complicated */
-	nr_possible = ptr_list_size((struct ptr_list *)sm->possible);
+	nr_possible = sm->nr_possible;
 	nr_states = stree_count(__get_cur_stree());
 	if (nr_states * nr_possible >= 2000)
 		return 0;
@@ -1871,7 +2026,6 @@ static void init_memdb(void)
 		"db/type_size.schema",
 		"db/call_implies.schema",
 		"db/function_ptr.schema",
-		"db/local_values.schema",
 		"db/function_type_value.schema",
 		"db/type_value.schema",
 		"db/function_type.schema",
@@ -31,14 +31,14 @@
 #include "smatch_slist.h"
 #include "smatch_extra.h"
 
-ALLOCATOR(relation, "related variables");
+ARENA_ALLOCATOR(relation, "related variables", &function_arena);
 
 static struct relation *alloc_relation(const char *name, struct symbol *sym)
 {
 	struct relation *tmp;
 
 	tmp = __alloc_relation(0);
-	tmp->name = alloc_string(name);
+	tmp->name = alloc_sname(name);
 	tmp->sym = sym;
 	return tmp;
 }
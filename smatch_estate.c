@@ -396,8 +396,7 @@ struct data_info *clone_dinfo_perm(struct data_info *dinfo)
 {
 	struct data_info *ret;
 
-	ret = malloc(sizeof(*ret));
-	memset(ret, 0, sizeof(*ret));
+	ret = alloc_perm_dinfo();
 	ret->related = NULL;
 	ret->value_ranges = clone_rl_permanent(dinfo->value_ranges);
 	ret->hard_max = 0;
@@ -409,8 +408,8 @@ struct smatch_state *clone_estate_perm(struct smatch_state *state)
 {
 	struct smatch_state *ret;
 
-	ret = malloc(sizeof(*ret));
-	ret->name = alloc_string(state->name);
+	ret = alloc_perm_smatch_state();
+	ret->name = alloc_perm_sname(state->name);
 	ret->data = clone_dinfo_perm(get_dinfo(state));
 	return ret;
 }
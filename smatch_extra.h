@@ -107,6 +107,7 @@ void split_comparison_rl(struct range_list *left_orig, int op, struct range_list
 
 void free_rl(struct range_list **rlist);
 void free_data_info_allocs(void);
+struct data_info *alloc_perm_dinfo(void);
 
 /* smatch_estate.c */
 
@@ -17,7 +17,12 @@
 
 #define _GNU_SOURCE 1
 #include <unistd.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include "token.h"
 #include "scope.h"
 #include "smatch.h"
@@ -67,9 +72,12 @@ static void split_declaration(struct symbol_list *sym_list);
 static void split_expr_list(struct expression_list *expr_list, struct expression *parent);
 static void add_inline_function(struct symbol *sym);
 static void parse_inline(struct expression *expr);
+static void shard_unit_start(const char *kind, struct symbol *sym);
+static void shard_unit_end(void);
 
 int option_assume_loops = 0;
 int option_two_passes = 0;
+int option_jobs;
 struct symbol *cur_func_sym = NULL;
 struct stree *global_states;
 
@@ -204,6 +212,7 @@ int inlinable(struct expression *expr)
 		// printf("\t is_no_inline_function\n");
 		return 0;
 	}
+	parse_lazy_body(expr->symbol);
 	sym = get_base_type(expr->symbol);
 	if (sym->stmt && sym->stmt->type == STMT_COMPOUND) {
 		// if (ptr_list_size((struct ptr_list *)sym->stmt->stmts) > 10) {
@@ -1533,10 +1542,13 @@ static void split_function(struct symbol *sym)
 {
 	struct symbol *base_type = get_base_type(sym);
 
+	parse_lazy_body(sym);
 	if (!base_type->stmt && !base_type->inline_stmt)
 		return;
 
 	gettimeofday(&fn_start_time, NULL);
+	mem_stats_start_function();
+	cost_stats_start_function();
 	cur_func_sym = sym;
 	if (sym->ident)
 		cur_func = sym->ident->name;
@@ -1568,10 +1580,13 @@ static void split_function(struct symbol *sym)
 	if (current_syscall == sym)
 	    current_syscall = NULL;
 
+	mem_stats_end_function();
+	cost_stats_end_function();
 	clear_all_states();
 	cur_func_sym = NULL;
 	cur_func = NULL;
 	free_data_info_allocs();
+	free_function_arena();
 	free_expression_stack(&switch_expr_stack);
 	__free_ptr_list((struct ptr_list **)&big_statement_stack);
 	__bail_on_rest_of_function = 0;
@@ -1632,6 +1647,7 @@ static void parse_inline(struct expression *call)
 	final_pass = 0;  /* don't print anything */
 	__inline_fn = call;
 
+	function_cache_inline_call(call->fn->symbol);
 	base_type = get_base_type(call->fn->symbol);
 	cur_func_sym = call->fn->symbol;
 	if (call->fn->symbol->ident)
@@ -1689,7 +1705,9 @@ static void process_inlines(void)
 	struct symbol *tmp;
 
 	FOR_EACH_PTR(inlines_called, tmp) {
+		shard_unit_start("inline", tmp);
 		split_function(tmp);
+		shard_unit_end();
 	} END_FOR_EACH_PTR(tmp);
 	free_ptr_list(&inlines_called);
 }
@@ -1730,6 +1748,7 @@ static void split_inlines_in_scope(struct symbol *sym)
 			continue;
 		if (base->type != SYM_FN)
 			continue;
+		parse_lazy_body(sym);
 		if (!base->inline_stmt)
 			continue;
 		add_inline_function(sym);
@@ -1787,10 +1806,571 @@ static bool interesting_function(struct symbol *sym)
 }
 
 struct position last_pos;
+
+/*
+ * --jobs=<n> analyses the functions in a file on a pool of forked workers.
+ * Pretty much everything Smatch tracks is a global so the easiest way to give
+ * each worker its own copy of the parsed file, the cur stree and the
+ * allocators is fork().  The workers take the next function from a shared
+ * counter and write out a frame with the output for that function and a list
+ * of the inline functions it called down a pipe.  The parent prints each
+ * frame as soon as the frames for the functions before it are printed so the
+ * output comes out in the same order as a serial run, and it still handles
+ * the inline functions itself.
+ *
+ * --info and --debug still run serially.  The local_values code needs to see
+ * every function in the file and the debug output goes straight to stdout.
+ * --mem-stats is serial as well because the allocator counters are per process.
+ * Checks which carry state from one function to the next call
+ * run_functions_serially() when they are registered.
+ */
+#define NR_OUTPUTS 3
+
+struct frame_header {
+	int idx;
+	int nr_inlines;
+	int len[NR_OUTPUTS];
+};
+
+struct func_output {
+	int done;
+	char *buf[NR_OUTPUTS];
+	struct frame_header header;
+	struct symbol_list *inlines;
+};
+
+static FILE **get_output_fd(int i)
+{
+	switch (i) {
+	case 0:
+		return &sm_outfd;
+	case 1:
+		return &sql_outfd;
+	default:
+		return &caller_info_fd;
+	}
+}
+
+struct output_capture {
+	FILE *orig[NR_OUTPUTS];
+	FILE *mem[NR_OUTPUTS];
+	int shared[NR_OUTPUTS];
+	char *buf[NR_OUTPUTS];
+	size_t size[NR_OUTPUTS];
+};
+
+static void start_output_capture(struct output_capture *cap)
+{
+	int i, j;
+
+	/*
+	 * Normally sm_outfd, sql_outfd and caller_info_fd are all stdout so
+	 * they have to share a buffer to stay in order.
+	 */
+	for (i = 0; i < NR_OUTPUTS; i++) {
+		cap->orig[i] = *get_output_fd(i);
+		cap->buf[i] = NULL;
+		cap->size[i] = 0;
+		cap->shared[i] = 0;
+		cap->mem[i] = NULL;
+		for (j = 0; j < i; j++) {
+			if (cap->orig[j] == cap->orig[i]) {
+				cap->mem[i] = cap->mem[j];
+				cap->shared[i] = 1;
+				break;
+			}
+		}
+		if (!cap->mem[i])
+			cap->mem[i] = open_memstream(&cap->buf[i], &cap->size[i]);
+		if (!cap->mem[i]) {
+			cap->mem[i] = cap->orig[i];
+			cap->shared[i] = 1;
+		}
+		*get_output_fd(i) = cap->mem[i];
+	}
+}
+
+static void end_output_capture(struct output_capture *cap)
+{
+	int i;
+
+	for (i = 0; i < NR_OUTPUTS; i++) {
+		*get_output_fd(i) = cap->orig[i];
+		if (!cap->shared[i])
+			fclose(cap->mem[i]);
+	}
+}
+
+static void free_output_capture(struct output_capture *cap)
+{
+	int i;
+
+	for (i = 0; i < NR_OUTPUTS; i++)
+		free(cap->buf[i]);
+}
+
+static void write_outputs(char **buf, size_t *size)
+{
+	int i;
+
+	for (i = 0; i < NR_OUTPUTS; i++) {
+		if (size[i])
+			fwrite(buf[i], 1, size[i], *get_output_fd(i));
+	}
+}
+
+static void split_function_to_frame(FILE *frames, struct symbol *sym, int idx)
+{
+	struct frame_header header = { .idx = idx };
+	struct output_capture cap;
+	struct symbol *tmp;
+	int i;
+
+	start_output_capture(&cap);
+	split_function(sym);
+	end_output_capture(&cap);
+
+	header.nr_inlines = ptr_list_size((struct ptr_list *)inlines_called);
+	for (i = 0; i < NR_OUTPUTS; i++)
+		header.len[i] = cap.size[i];
+	fwrite(&header, sizeof(header), 1, frames);
+	FOR_EACH_PTR(inlines_called, tmp) {
+		fwrite(&tmp, sizeof(tmp), 1, frames);
+	} END_FOR_EACH_PTR(tmp);
+	for (i = 0; i < NR_OUTPUTS; i++) {
+		if (cap.size[i])
+			fwrite(cap.buf[i], 1, cap.size[i], frames);
+	}
+	free_output_capture(&cap);
+	fflush(frames);
+	free_ptr_list(&inlines_called);
+}
+
+/*
+ * With --function-cache the output of the function is either printed from
+ * the cache or it's captured and saved after the function is parsed.
+ */
+static void split_function_cached(struct symbol *sym)
+{
+	struct output_capture cap;
+	char *buf[NR_OUTPUTS];
+	size_t size[NR_OUTPUTS];
+	struct position end_pos;
+	int nr_inlines;
+	int i;
+
+	if (function_cache_replay(sym, buf, size, NR_OUTPUTS, &end_pos)) {
+		/* the end of file output uses the last position */
+		set_position(end_pos);
+		write_outputs(buf, size);
+		for (i = 0; i < NR_OUTPUTS; i++)
+			free(buf[i]);
+		return;
+	}
+
+	nr_inlines = ptr_list_size((struct ptr_list *)inlines_called);
+	function_cache_start(sym);
+	start_output_capture(&cap);
+	split_function(sym);
+	end_output_capture(&cap);
+	/* the inline functions it found are parsed afterwards */
+	if (ptr_list_size((struct ptr_list *)inlines_called) != nr_inlines)
+		function_cache_uncacheable();
+	for (i = 0; i < NR_OUTPUTS; i++) {
+		if (cap.mem[i] == cap.orig[i])
+			function_cache_uncacheable();
+	}
+	end_pos = sym->pos;
+	end_pos.line = get_lineno();
+	function_cache_end(sym, cap.buf, cap.size, NR_OUTPUTS, end_pos);
+	write_outputs(cap.buf, cap.size);
+	free_output_capture(&cap);
+}
+
+static void split_functions_worker(struct symbol **fns, int nr, int *next, FILE *frames)
+{
+	int idx;
+
+	while ((idx = __sync_fetch_and_add(next, 1)) < nr)
+		split_function_to_frame(frames, fns[idx], idx);
+}
+
+struct frame_reader {
+	int fd;
+	char *data;
+	size_t len, size;
+};
+
+/*
+ * Take the complete frames out of what a worker has sent so far.  A partial
+ * frame stays in the buffer until the rest of it arrives.
+ */
+static int parse_frames(struct frame_reader *rd, struct func_output *out, int nr)
+{
+	struct frame_header header;
+	struct symbol *sym;
+	size_t pos = 0, need;
+	int i;
+
+	while (rd->len - pos >= sizeof(header)) {
+		memcpy(&header, rd->data + pos, sizeof(header));
+		if (header.idx < 0 || header.idx >= nr || out[header.idx].done ||
+		    header.nr_inlines < 0)
+			return -1;
+		need = sizeof(header) + (size_t)header.nr_inlines * sizeof(sym);
+		for (i = 0; i < NR_OUTPUTS; i++) {
+			if (header.len[i] < 0)
+				return -1;
+			need += header.len[i];
+		}
+		if (rd->len - pos < need)
+			break;
+
+		pos += sizeof(header);
+		for (i = 0; i < header.nr_inlines; i++) {
+			memcpy(&sym, rd->data + pos, sizeof(sym));
+			pos += sizeof(sym);
+			add_ptr_list(&out[header.idx].inlines, sym);
+		}
+		for (i = 0; i < NR_OUTPUTS; i++) {
+			out[header.idx].buf[i] = malloc(header.len[i] + 1);
+			memcpy(out[header.idx].buf[i], rd->data + pos, header.len[i]);
+			pos += header.len[i];
+		}
+		out[header.idx].header = header;
+		out[header.idx].done = 1;
+	}
+
+	rd->len -= pos;
+	memmove(rd->data, rd->data + pos, rd->len);
+	return 0;
+}
+
+/*
+ * Returns -1 when the worker is finished or it sent something that isn't a
+ * frame.  Whatever it didn't send is analysed by the parent.
+ */
+static int read_frames(struct frame_reader *rd, struct func_output *out, int nr)
+{
+	ssize_t ret;
+	char *data;
+
+	if (rd->len + 4096 > rd->size) {
+		data = realloc(rd->data, rd->size ? rd->size * 2 : 65536);
+		if (!data)
+			return -1;
+		rd->data = data;
+		rd->size = rd->size ? rd->size * 2 : 65536;
+	}
+	ret = read(rd->fd, rd->data + rd->len, rd->size - rd->len);
+	if (ret < 0 && errno == EINTR)
+		return 0;
+	if (ret <= 0)
+		return -1;
+	rd->len += ret;
+	return parse_frames(rd, out, nr);
+}
+
+static void print_frame(struct symbol *fn, struct func_output *out)
+{
+	struct symbol *sym;
+	int i;
+
+	set_position(fn->pos);
+	last_pos = fn->pos;
+	if (!out->done) {
+		split_function(fn);
+		process_inlines();
+		return;
+	}
+	for (i = 0; i < NR_OUTPUTS; i++) {
+		if (out->header.len[i])
+			fwrite(out->buf[i], 1, out->header.len[i],
+			       *get_output_fd(i));
+		free(out->buf[i]);
+	}
+	FOR_EACH_PTR(out->inlines, sym) {
+		add_inline_function(sym);
+	} END_FOR_EACH_PTR(sym);
+	free_ptr_list(&out->inlines);
+	process_inlines();
+}
+
+static int functions_serially;
+
+void run_functions_serially(void)
+{
+	functions_serially = 1;
+}
+
+static void split_functions_parallel(struct symbol **fns, int nr)
+{
+	struct func_output *out;
+	struct frame_reader *readers;
+	struct pollfd *fds;
+	pid_t *pids;
+	int *next;
+	int workers = 0, running, printed = 0;
+	int pipes[2];
+	int i, j, n;
+
+	next = mmap(NULL, sizeof(*next), PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (next == MAP_FAILED)
+		next = NULL;
+	readers = calloc(option_jobs, sizeof(*readers));
+	fds = calloc(option_jobs, sizeof(*fds));
+	pids = calloc(option_jobs, sizeof(*pids));
+	out = calloc(nr, sizeof(*out));
+
+	fflush(stdout);
+	fflush(stderr);
+	fflush(sm_outfd);
+	fflush(sql_outfd);
+	fflush(caller_info_fd);
+	info_frames_flush();
+
+	for (i = 0; next && i < option_jobs && i < nr; i++) {
+		if (pipe(pipes) < 0)
+			break;
+		pids[workers] = fork();
+		if (pids[workers] < 0) {
+			close(pipes[0]);
+			close(pipes[1]);
+			break;
+		}
+		if (pids[workers] == 0) {
+			FILE *frames;
+
+			for (j = 0; j < workers; j++)
+				close(readers[j].fd);
+			close(pipes[0]);
+			frames = fdopen(pipes[1], "w");
+			if (!frames)
+				_exit(1);
+			split_functions_worker(fns, nr, next, frames);
+			fclose(frames);
+			info_frames_flush();
+			_exit(0);
+		}
+		close(pipes[1]);
+		readers[workers].fd = pipes[0];
+		workers++;
+	}
+
+	/* print each frame as soon as everything before it has been printed */
+	running = workers;
+	while (running) {
+		n = 0;
+		for (i = 0; i < workers; i++) {
+			if (readers[i].fd < 0)
+				continue;
+			fds[n].fd = readers[i].fd;
+			fds[n].events = POLLIN;
+			n++;
+		}
+		if (poll(fds, n, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (i = 0, j = 0; i < workers; i++) {
+			if (readers[i].fd < 0)
+				continue;
+			if (fds[j++].revents &&
+			    read_frames(&readers[i], out, nr) < 0) {
+				close(readers[i].fd);
+				readers[i].fd = -1;
+				running--;
+			}
+		}
+		while (printed < nr && out[printed].done) {
+			print_frame(fns[printed], &out[printed]);
+			printed++;
+		}
+	}
+
+	for (i = 0; i < workers; i++) {
+		if (readers[i].fd >= 0)
+			close(readers[i].fd);
+		free(readers[i].data);
+		waitpid(pids[i], NULL, 0);
+	}
+
+	/* anything a worker didn't finish is done here the normal way */
+	for (; printed < nr; printed++)
+		print_frame(fns[printed], &out[printed]);
+
+	if (next)
+		munmap(next, sizeof(*next));
+	free(out);
+	free(pids);
+	free(fds);
+	free(readers);
+}
+
+/*
+ * --function-range=<start>:<count> and --function-shard=<n>/<total> only
+ * analyse some of the functions in a file.  That way one huge file can be
+ * split across several smatch processes and the output put back together
+ * with smatch_scripts/merge_function_shards.py.
+ *
+ * The whole file is still parsed and every process still does the file
+ * level work.  The output is split into units with "smatch_shard:" lines
+ * so the merge script can put the units back in the order a normal run
+ * would print them:
+ *
+ *	file|<base file>|<functions>|<last symbol is a function>|<return_id>
+ *	unit|<kind>|<index>|<name>|<line>|<return_id>
+ *	unit_end|<return_id>|<filename>|<line>
+ *	loop_end|<filename>|<line>
+ *	end_file|<return_id>|<filename>|<line>
+ *	done
+ *
+ * A unit is a function or one of the inline functions that gets split after
+ * it.  An inline function is split after the first function which calls it
+ * so every process which calls it prints it and the merge keeps the first.
+ * The return_ids count up through the whole file, so each unit records
+ * where it started and the merge renumbers them.  The first function in the
+ * file is always analysed because it picks up the states which the file
+ * level hooks left behind but the output is only kept by its own shard.
+ */
+char *option_function_range;
+char *option_function_shard;
+static int range_start, range_count;
+static int shard_nr, shard_total;
+static int shard_idx;
+
+int function_shard_mode(void)
+{
+	return option_function_range || option_function_shard;
+}
+
+static void shard_marker(const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	fprintf(sm_outfd, "smatch_shard: ");
+	vfprintf(sm_outfd, fmt, args);
+	fprintf(sm_outfd, "\n");
+	va_end(args);
+}
+
+static void shard_unit_start(const char *kind, struct symbol *sym)
+{
+	if (!function_shard_mode())
+		return;
+	shard_marker("unit|%s|%d|%s|%d|%d", kind, shard_idx,
+		     sym->ident ? sym->ident->name : "", sym->pos.line,
+		     get_return_id());
+}
+
+static void shard_unit_end(void)
+{
+	if (!function_shard_mode())
+		return;
+	shard_marker("unit_end|%d|%s|%d", get_return_id(), get_filename(),
+		     get_lineno());
+}
+
+void parse_function_shard_options(void)
+{
+	if (!function_shard_mode())
+		return;
+
+	if (option_function_range &&
+	    sscanf(option_function_range, "%d:%d", &range_start, &range_count) != 2) {
+		printf("FATAL ERROR: --function-range=<start>:<count>\n");
+		exit(1);
+	}
+	if (option_function_shard &&
+	    (sscanf(option_function_shard, "%d/%d", &shard_nr, &shard_total) != 2 ||
+	     shard_total < 1 || shard_nr < 0 || shard_nr >= shard_total)) {
+		printf("FATAL ERROR: --function-shard=<n>/<total> where 0 <= n < total\n");
+		exit(1);
+	}
+	if (option_function_range && option_function_shard) {
+		printf("FATAL ERROR: use either --function-range or --function-shard\n");
+		exit(1);
+	}
+	/* the markers have to be in the same stream as the output */
+	if (option_file_output || option_info_frames) {
+		printf("FATAL ERROR: --function-range and --function-shard print to stdout only\n");
+		exit(1);
+	}
+}
+
+static unsigned int hash_function_name(struct symbol *sym, int idx)
+{
+	unsigned int hash = 2166136261U;
+	const char *p;
+
+	if (!sym->ident)
+		return idx;
+	for (p = sym->ident->name; *p; p++)
+		hash = (hash ^ (unsigned char)*p) * 16777619U;
+	return hash;
+}
+
+static int in_this_shard(struct symbol *sym, int idx)
+{
+	if (option_server)
+		return server_wants_function(sym);
+	if (option_function_range)
+		return idx >= range_start && idx - range_start < range_count;
+	return hash_function_name(sym, idx) % shard_total == shard_nr;
+}
+
+static int is_file_function(struct symbol *sym)
+{
+	return sym->type == SYM_NODE && get_base_type(sym)->type == SYM_FN &&
+	       interesting_function(sym);
+}
+
+static void shard_start_file(struct symbol_list *sym_list)
+{
+	struct symbol *sym, *last = NULL;
+	int nr = 0;
+
+	FOR_EACH_PTR(sym_list, sym) {
+		last = sym;
+		if (is_file_function(sym))
+			nr++;
+	} END_FOR_EACH_PTR(sym);
+
+	shard_idx = 0;
+	if (!function_shard_mode())
+		return;
+	shard_marker("file|%s|%d|%d|%d", get_base_file(), nr,
+		     last && is_file_function(last), get_return_id());
+}
+
+static void split_function_shard(struct symbol *sym)
+{
+	struct output_capture cap;
+
+	if (in_this_shard(sym, shard_idx)) {
+		shard_unit_start("function", sym);
+		split_function(sym);
+		shard_unit_end();
+	} else if (shard_idx == 0) {
+		start_output_capture(&cap);
+		split_function(sym);
+		end_output_capture(&cap);
+		free_output_capture(&cap);
+	}
+	process_inlines();
+	shard_idx++;
+}
+
 static void split_c_file_functions(struct symbol_list *sym_list)
 {
+	struct symbol **fns = NULL;
 	struct symbol *sym;
+	int nr = 0;
 
+	function_cache_start_file(sym_list);
 	__unnullify_path();
 	FOR_EACH_PTR(sym_list, sym) {
 		set_position(sym->pos);
@@ -1802,19 +2382,64 @@ static void split_c_file_functions(struct symbol_list *sym_list)
 	global_states = clone_estates_perm(get_all_states_stree(SMATCH_EXTRA));
 	nullify_path();
 
+	if (option_jobs > 1 && !functions_serially && !option_info &&
+	    !option_debug && !option_mem_stats && !function_shard_mode() &&
+	    !option_server)
+		fns = malloc(ptr_list_size((struct ptr_list *)sym_list) * sizeof(*fns));
+	if (function_shard_mode() || option_server)
+		shard_start_file(sym_list);
+	server_start_file(sym_list);
+
 	FOR_EACH_PTR(sym_list, sym) {
 		set_position(sym->pos);
 		last_pos = sym->pos;
 		if (!interesting_function(sym))
 			continue;
 		if (sym->type == SYM_NODE && get_base_type(sym)->type == SYM_FN) {
-			split_function(sym);
+			if (fns) {
+				fns[nr++] = sym;
+				continue;
+			}
+			if (function_shard_mode() || option_server) {
+				split_function_shard(sym);
+				continue;
+			}
+			if (option_function_cache)
+				split_function_cached(sym);
+			else
+				split_function(sym);
 			process_inlines();
 		}
 		last_pos = sym->pos;
 	} END_FOR_EACH_PTR(sym);
-	split_inlines(sym_list);
+	if (fns) {
+		split_functions_parallel(fns, nr);
+		free(fns);
+	}
+	if (function_shard_mode())
+		shard_marker("loop_end|%s|%d", get_filename(), get_lineno());
+	if (server_checks_whole_file())
+		split_inlines(sym_list);
+	if (function_shard_mode())
+		shard_marker("end_file|%d|%s|%d", get_return_id(), get_filename(),
+			     get_lineno());
 	__pass_to_client(sym_list, END_FILE_HOOK);
+	mem_stats_end_file();
+	if (function_shard_mode())
+		shard_marker("done");
+}
+
+/* used by the --server children */
+void smatch_check_file(char *filename, int fd)
+{
+	struct symbol_list *sym_list;
+
+	base_file = filename;
+	if (fd < 0)
+		sym_list = sparse_keep_tokens(filename);
+	else
+		sym_list = sparse_keep_tokens_fd(filename, fd);
+	split_c_file_functions(sym_list);
 }
 
 static int final_before_fake;
@@ -1868,26 +2493,41 @@ void smatch(int argc, char **argv)
 {
 	struct string_list *filelist = NULL;
 	struct symbol_list *sym_list;
-	struct timeval stop, start;
+	struct timeval stop, start, file_start, parsed;
 
 	gettimeofday(&start, NULL);
 
-	if (argc < 2) {
+	if (argc < 2 && !option_server) {
 		printf("Usage:  smatch [--debug] <filename.c>\n");
 		exit(1);
 	}
+	/* we keep the tokens so inline bodies can be parsed when they're used */
+	flazy_inline = 1;
+	sparse_init_without_files = option_server;
 	sparse_initialize(argc, argv, &filelist);
 	set_valid_ptr_max();
+	parse_function_shard_options();
+	function_cache_init();
+	if (option_server) {
+		server_main();
+		return;
+	}
 	FOR_EACH_PTR_NOTAG(filelist, base_file) {
 		if (option_file_output)
 			open_output_files(base_file);
+		gettimeofday(&file_start, NULL);
 		sym_list = sparse_keep_tokens(base_file);
+		gettimeofday(&parsed, NULL);
 		split_c_file_functions(sym_list);
+		cost_stats_end_file(&file_start, &parsed);
+		info_frames_flush();
 	} END_FOR_EACH_PTR_NOTAG(base_file);
 
 	gettimeofday(&stop, NULL);
 
 	set_position(last_pos);
-	if (option_time)
+	if (option_time) {
 		sm_msg("time: %lu", stop.tv_sec - start.tv_sec);
+		function_cache_print_stats();
+	}
 }
@@ -0,0 +1,805 @@
+/*
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * --function-cache=<dir> saves the output of every function to <dir>.  The
+ * next time smatch sees the same function it prints the saved output
+ * instead of parsing the function again.
+ *
+ * The output of a function depends on three things:
+ *
+ * 1) The tokens.  The file is hashed once after it's preprocessed.  The body
+ *    of each function gets its own hash and everything else (the headers,
+ *    the declarations, the inline functions) goes into one context hash.  The
+ *    smatch binary, the command line and the DB queries which ran before
+ *    the first function go into the context hash as well.  The cache file
+ *    is named after a hash of the context, the function name and the body.
+ *
+ *    The line numbers are left out of the context hash and the lines in the
+ *    body are hashed from the start of the function so adding a line
+ *    somewhere else in the file doesn't throw the cache away.  The start
+ *    line is saved and when the function has moved the line numbers in the
+ *    saved output are moved by the same amount.
+ *
+ * 2) The DB.  While a function is parsed each query and a hash of the rows
+ *    it returned are recorded.  Before the output is used again the queries
+ *    are run again and the hashes have to match.  Tables which are read
+ *    into memory once and used by every function after that are marked
+ *    with function_cache_sticky() and they're recorded for every function.
+ *
+ * 3) The bodies of the functions it parses inline.  Their names and hashes
+ *    are recorded and checked as well.
+ *
+ * --info prints a return_id which counts up through the file so with --info
+ * the saved output is only used if the count is the same as last time.
+ *
+ * Functions which leave state behind for later functions, such as the
+ * static variables for smatch_local_values.c or the static inline functions
+ * which are parsed afterwards, call function_cache_uncacheable() and are
+ * not saved.  The files in smatch_data/ are not tracked so the cache has to
+ * be cleared when they change.
+ */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "smatch.h"
+#include "smatch_function_hashtable.h"
+
+#define CACHE_MAGIC "SMFC"
+#define CACHE_VERSION 2
+
+char *option_function_cache;
+
+struct cache_func {
+	struct position pos;
+	struct symbol *sym;
+	struct cache_hash body;
+	int end_line;
+};
+
+struct cache_query {
+	char *sql;
+	struct cache_hash hash;
+};
+DECLARE_PTR_LIST(cache_query_list, struct cache_query);
+
+struct cache_inline {
+	char *name;
+	struct cache_hash hash;
+};
+DECLARE_PTR_LIST(cache_inline_list, struct cache_inline);
+
+static struct cache_hash process_context;
+static struct cache_hash file_context;
+static struct cache_func *funcs;
+static int nr_funcs;
+static int file_started;
+static int first_in_file;
+
+/* what the function being recorded used */
+static struct symbol *recording;
+static int recording_ok;
+static int start_return_id;
+static struct cache_query_list *deps;
+static struct cache_inline_list *inline_deps;
+static struct hashtable *deps_seen;
+
+/* tables which are loaded once and used by every function after */
+static int sticky;
+static struct cache_query_list *sticky_queries;
+
+/* every query whose hash we know in this process */
+static DEFINE_HASHTABLE_INSERT(insert_known_query, char, struct cache_hash);
+static DEFINE_HASHTABLE_SEARCH(search_known_query, char, struct cache_hash);
+static struct hashtable *known_queries;
+
+static int stat_hits, stat_misses, stat_stale, stat_saved, stat_uncacheable;
+
+void cache_hash_init(struct cache_hash *hash)
+{
+	hash->a = 0xcbf29ce484222325ULL;
+	hash->b = 0x9e3779b97f4a7c15ULL;
+}
+
+void cache_hash_bytes(struct cache_hash *hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash->a = (hash->a ^ p[i]) * 0x100000001b3ULL;
+		hash->b = (hash->b + p[i]) * 0xff51afd7ed558ccdULL;
+		hash->b ^= hash->b >> 33;
+	}
+}
+
+void cache_hash_str(struct cache_hash *hash, const char *str)
+{
+	if (!str)
+		str = "";
+	cache_hash_bytes(hash, str, strlen(str) + 1);
+}
+
+static void cache_hash_int(struct cache_hash *hash, unsigned int val)
+{
+	cache_hash_bytes(hash, &val, sizeof(val));
+}
+
+void cache_hash_row(struct cache_hash *hash, int argc, char **argv)
+{
+	int i;
+
+	cache_hash_int(hash, argc);
+	for (i = 0; i < argc; i++) {
+		if (!argv[i])
+			cache_hash_bytes(hash, "\1", 1);
+		else
+			cache_hash_str(hash, argv[i]);
+	}
+}
+
+static int hash_equal(struct cache_hash *one, struct cache_hash *two)
+{
+	return one->a == two->a && one->b == two->b;
+}
+
+static void remember_query(const char *sql, struct cache_hash *hash)
+{
+	struct cache_hash *known;
+
+	if (!known_queries)
+		known_queries = create_function_hashtable(4000);
+	if (search_known_query(known_queries, (char *)sql))
+		return;
+	known = malloc(sizeof(*known));
+	*known = *hash;
+	insert_known_query(known_queries, alloc_string(sql), known);
+}
+
+static struct cache_hash *get_query_hash(const char *sql)
+{
+	struct cache_hash hash;
+	struct cache_hash *known;
+
+	if (known_queries) {
+		known = search_known_query(known_queries, (char *)sql);
+		if (known)
+			return known;
+	}
+	cache_hash_init(&hash);
+	sql_hash_rows(sql, &hash);
+	remember_query(sql, &hash);
+	return search_known_query(known_queries, (char *)sql);
+}
+
+static struct cache_query *alloc_query(const char *sql, struct cache_hash *hash)
+{
+	struct cache_query *query = malloc(sizeof(*query));
+
+	query->sql = alloc_string(sql);
+	query->hash = *hash;
+	return query;
+}
+
+static void free_queries(struct cache_query_list **list)
+{
+	struct cache_query *query;
+
+	FOR_EACH_PTR(*list, query) {
+		free_string(query->sql);
+		free(query);
+	} END_FOR_EACH_PTR(query);
+	free_ptr_list(list);
+}
+
+static void free_inline_deps(void)
+{
+	struct cache_inline *dep;
+
+	FOR_EACH_PTR(inline_deps, dep) {
+		free_string(dep->name);
+		free(dep);
+	} END_FOR_EACH_PTR(dep);
+	free_ptr_list(&inline_deps);
+}
+
+int function_cache_recording(void)
+{
+	return !!option_function_cache;
+}
+
+void function_cache_add_query(const char *sql, struct cache_hash *hash)
+{
+	struct cache_query *query;
+	struct cache_hash *context;
+
+	remember_query(sql, hash);
+
+	if (sticky) {
+		query = alloc_query(sql, hash);
+		add_ptr_list(&sticky_queries, query);
+	}
+
+	/* the queries from outside a function affect everything after */
+	if (!recording) {
+		context = file_started ? &file_context : &process_context;
+		cache_hash_str(context, sql);
+		cache_hash_bytes(context, hash, sizeof(*hash));
+		return;
+	}
+	if (search_known_query(deps_seen, (char *)sql))
+		return;
+	query = alloc_query(sql, hash);
+	insert_known_query(deps_seen, alloc_string(sql), &query->hash);
+	add_ptr_list(&deps, query);
+}
+
+void function_cache_sticky(int on)
+{
+	sticky = on;
+}
+
+void function_cache_uncacheable(void)
+{
+	recording_ok = 0;
+}
+
+static void hash_file(struct cache_hash *hash, const char *name)
+{
+	struct stat st;
+
+	cache_hash_str(hash, name);
+	if (stat(name, &st) == 0) {
+		cache_hash_bytes(hash, &st.st_size, sizeof(st.st_size));
+		cache_hash_bytes(hash, &st.st_mtime, sizeof(st.st_mtime));
+	}
+}
+
+static void hash_tokens(struct cache_hash *hash, struct token *token);
+
+/* this is called before the smatch options are taken out of argv */
+void function_cache_args(int argc, char **argv)
+{
+	int i;
+
+	cache_hash_init(&process_context);
+	cache_hash_int(&process_context, CACHE_VERSION);
+	hash_file(&process_context, "/proc/self/exe");
+	for (i = 0; i < argc; i++)
+		cache_hash_str(&process_context, argv[i]);
+}
+
+void function_cache_init(void)
+{
+	if (!option_function_cache)
+		return;
+
+	/* the output has to go through sm_outfd and friends in this process */
+	if (option_jobs > 1 || option_info_frames || option_debug || option_mem_stats ||
+	    option_cost_stats || function_shard_mode() || option_server) {
+		option_function_cache = NULL;
+		return;
+	}
+
+	mkdir(option_function_cache, 0755);
+
+	/* the builtin definitions and the -include files */
+	hash_tokens(&process_context, preprocessed_stream);
+}
+
+static int cmp_funcs(const void *_a, const void *_b)
+{
+	const struct cache_func *a = _a;
+	const struct cache_func *b = _b;
+
+	return cmp_pos(a->pos, b->pos);
+}
+
+static struct cache_func *find_func(struct position pos)
+{
+	int lo = 0, hi = nr_funcs;
+	int mid, cmp;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		cmp = cmp_pos(pos, funcs[mid].pos);
+		if (cmp == 0)
+			return &funcs[mid];
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
+/*
+ * The lines in a body are hashed relative to the start of the function.
+ * If "func" is NULL the lines aren't hashed at all.
+ */
+static void hash_one_token(struct cache_hash *hash, struct token *token, int *stream,
+			   struct cache_func *func)
+{
+	switch (token_type(token)) {
+	case TOKEN_EOF:
+	case TOKEN_STREAMBEGIN:
+	case TOKEN_STREAMEND:
+		return;
+	default:
+		break;
+	}
+
+	if (token->pos.stream != *stream) {
+		*stream = token->pos.stream;
+		cache_hash_str(hash, stream_name(*stream));
+	}
+	if (func) {
+		if (token->pos.stream == func->pos.stream)
+			cache_hash_int(hash, token->pos.line - func->pos.line);
+		else
+			cache_hash_int(hash, token->pos.line);
+	}
+	cache_hash_int(hash, token_type(token));
+	cache_hash_str(hash, show_token(token));
+}
+
+static void hash_tokens(struct cache_hash *hash, struct token *token)
+{
+	int stream = -1;
+
+	for (; token && !eof_token(token); token = token->next)
+		hash_one_token(hash, token, &stream, NULL);
+}
+
+/*
+ * The function bodies are found by looking for the start of the function at
+ * the top level and then taking everything from the next '{' to its matching '}'.
+ */
+static void hash_file_tokens(struct token *token)
+{
+	struct cache_func *pending = NULL;
+	struct cache_func *body = NULL;
+	struct cache_func *func;
+	int context_stream = -1;
+	int body_stream = -1;
+	int depth = 0;
+
+	for (; token && !eof_token(token); token = token->next) {
+		/* the position is the '*' for functions which return pointers */
+		if (depth == 0) {
+			func = find_func(token->pos);
+			if (func)
+				pending = func;
+		}
+		if (match_op(token, '{')) {
+			if (depth == 0 && pending) {
+				body = pending;
+				body_stream = -1;
+			}
+			depth++;
+		}
+
+		if (body)
+			hash_one_token(&body->body, token, &body_stream, body);
+		else
+			hash_one_token(&file_context, token, &context_stream, NULL);
+
+		if (match_op(token, '}') && depth > 0 && --depth == 0) {
+			if (body && token->pos.stream == body->pos.stream)
+				body->end_line = token->pos.line;
+			body = NULL;
+			pending = NULL;
+		}
+		if (depth == 0 && match_op(token, ';'))
+			pending = NULL;
+	}
+}
+
+static int has_body(struct symbol *sym)
+{
+	struct symbol *base = get_base_type(sym);
+
+	return base->stmt || sym->lazy_body;
+}
+
+void function_cache_start_file(struct symbol_list *sym_list)
+{
+	struct symbol *sym;
+	int i;
+
+	if (!option_function_cache)
+		return;
+
+	free(funcs);
+	funcs = malloc((ptr_list_size((struct ptr_list *)sym_list) + 1) * sizeof(*funcs));
+	nr_funcs = 0;
+	FOR_EACH_PTR(sym_list, sym) {
+		if (sym->type != SYM_NODE || get_base_type(sym)->type != SYM_FN)
+			continue;
+		if (sym->ctype.modifiers & MOD_INLINE)
+			continue;
+		if (!has_body(sym))
+			continue;
+		funcs[nr_funcs].pos = sym->pos;
+		funcs[nr_funcs].sym = sym;
+		cache_hash_init(&funcs[nr_funcs].body);
+		funcs[nr_funcs].end_line = sym->pos.line;
+		nr_funcs++;
+	} END_FOR_EACH_PTR(sym);
+	qsort(funcs, nr_funcs, sizeof(*funcs), cmp_funcs);
+
+	file_context = process_context;
+	cache_hash_str(&file_context, get_base_file());
+	hash_file_tokens(preprocessed_stream);
+	file_started = 1;
+	/* the file level hooks leave states behind for the first function */
+	first_in_file = 1;
+
+	/* two functions at the same spot would get mixed up */
+	for (i = 1; i < nr_funcs; i++) {
+		if (cmp_pos(funcs[i - 1].pos, funcs[i].pos) == 0) {
+			nr_funcs = 0;
+			break;
+		}
+	}
+}
+
+static struct cache_func *get_cache_func(struct symbol *sym)
+{
+	struct cache_func *func = find_func(sym->pos);
+
+	if (!func || func->sym != sym)
+		return NULL;
+	return func;
+}
+
+static struct cache_hash *get_body_hash(struct symbol *sym)
+{
+	struct cache_func *func = get_cache_func(sym);
+
+	return func ? &func->body : NULL;
+}
+
+static int get_cache_file(struct symbol *sym, char *buf, int size)
+{
+	struct cache_hash key = file_context;
+	struct cache_hash *body;
+
+	if (!sym->ident)
+		return 0;
+	cache_hash_str(&key, sym->ident->name);
+	body = get_body_hash(sym);
+	if (!body)
+		return 0;
+	cache_hash_bytes(&key, body, sizeof(*body));
+
+	snprintf(buf, size, "%s/%016llx%016llx", option_function_cache, key.a, key.b);
+	return 1;
+}
+
+void function_cache_inline_call(struct symbol *sym)
+{
+	struct cache_inline *dep;
+	struct cache_hash *body;
+
+	if (!recording || !sym->ident)
+		return;
+
+	/* the inline keyword functions are part of the context already */
+	if (sym->ctype.modifiers & MOD_INLINE)
+		return;
+	body = get_body_hash(sym);
+	if (!body) {
+		recording_ok = 0;
+		return;
+	}
+	FOR_EACH_PTR(inline_deps, dep) {
+		if (strcmp(dep->name, sym->ident->name) == 0)
+			return;
+	} END_FOR_EACH_PTR(dep);
+
+	dep = malloc(sizeof(*dep));
+	dep->name = alloc_string(sym->ident->name);
+	dep->hash = *body;
+	add_ptr_list(&inline_deps, dep);
+}
+
+static struct cache_hash *get_body_hash_by_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < nr_funcs; i++) {
+		if (funcs[i].sym->ident && strcmp(funcs[i].sym->ident->name, name) == 0)
+			return &funcs[i].body;
+	}
+	return NULL;
+}
+
+static void write_u32(FILE *f, unsigned int val)
+{
+	fwrite(&val, sizeof(val), 1, f);
+}
+
+static int read_u32(FILE *f, unsigned int *val)
+{
+	return fread(val, sizeof(*val), 1, f) == 1;
+}
+
+static void write_string(FILE *f, const char *str)
+{
+	write_u32(f, strlen(str));
+	fwrite(str, 1, strlen(str), f);
+}
+
+static char *read_string(FILE *f)
+{
+	unsigned int len;
+	char *str;
+
+	if (!read_u32(f, &len) || len > 1024 * 1024)
+		return NULL;
+	str = malloc(len + 1);
+	if (fread(str, 1, len, f) != len) {
+		free(str);
+		return NULL;
+	}
+	str[len] = '\0';
+	return str;
+}
+
+static int check_deps(FILE *f)
+{
+	struct cache_hash hash, *known;
+	unsigned int nr_queries, nr_inlines, i;
+	char *str;
+	int ret = 1;
+
+	if (!read_u32(f, &nr_queries) || !read_u32(f, &nr_inlines))
+		return 0;
+
+	for (i = 0; ret && i < nr_queries; i++) {
+		str = read_string(f);
+		if (!str || fread(&hash, sizeof(hash), 1, f) != 1) {
+			free(str);
+			return 0;
+		}
+		known = get_query_hash(str);
+		if (!known || !hash_equal(known, &hash))
+			ret = 0;
+		free(str);
+	}
+	for (i = 0; ret && i < nr_inlines; i++) {
+		str = read_string(f);
+		if (!str || fread(&hash, sizeof(hash), 1, f) != 1) {
+			free(str);
+			return 0;
+		}
+		known = get_body_hash_by_name(str);
+		if (!known || !hash_equal(known, &hash))
+			ret = 0;
+		free(str);
+	}
+	return ret;
+}
+
+static const char *move_number(FILE *out, const char *p, int start, int end, int delta)
+{
+	char *num_end;
+	long line;
+
+	line = strtol(p, &num_end, 10);
+	if (line >= start && line <= end)
+		line += delta;
+	fprintf(out, "%ld", line);
+	return num_end;
+}
+
+/*
+ * The function moved by "delta" lines since it was saved.  The messages
+ * start with "file.c:<line> " and some of them say "line <line>" as well.
+ * Only the numbers between the old start and end of the function are moved.
+ */
+static void move_lines(char **buf, size_t *size, int start, int end, int delta)
+{
+	const char *prefix = get_filename();
+	int prefix_len = strlen(prefix);
+	char *new_buf;
+	size_t new_size;
+	const char *p, *line_start, *line_end;
+	FILE *out;
+
+	out = open_memstream(&new_buf, &new_size);
+	if (!out)
+		return;
+	for (p = *buf; p < *buf + *size; p = line_end) {
+		line_start = p;
+		line_end = memchr(p, '\n', *buf + *size - p);
+		line_end = line_end ? line_end + 1 : *buf + *size;
+
+		if (strncmp(p, prefix, prefix_len) == 0 && p[prefix_len] == ':' &&
+		    isdigit((unsigned char)p[prefix_len + 1])) {
+			fwrite(p, 1, prefix_len + 1, out);
+			p = move_number(out, p + prefix_len + 1, start, end, delta);
+		}
+		while (p < line_end) {
+			if (line_end - p > 6 && strncmp(p, "line ", 5) == 0 &&
+			    isdigit((unsigned char)p[5]) &&
+			    (p == line_start || (!isalnum((unsigned char)p[-1]) && p[-1] != '_'))) {
+				fwrite(p, 1, 5, out);
+				p = move_number(out, p + 5, start, end, delta);
+				continue;
+			}
+			fputc(*p++, out);
+		}
+	}
+	fclose(out);
+	free(*buf);
+	*buf = new_buf;
+	*size = new_size;
+}
+
+int function_cache_replay(struct symbol *sym, char **buf, size_t *size, int nr,
+			  struct position *end_pos)
+{
+	unsigned int start_id, nr_ids, start_line;
+	int delta, end_line;
+	char name[PATH_MAX];
+	unsigned int len;
+	char magic[4];
+	FILE *f;
+	int i;
+
+	if (!option_function_cache || first_in_file)
+		return 0;
+	if (!get_cache_file(sym, name, sizeof(name)))
+		return 0;
+
+	f = fopen(name, "r");
+	if (!f) {
+		stat_misses++;
+		return 0;
+	}
+	if (fread(magic, 4, 1, f) != 1 || memcmp(magic, CACHE_MAGIC, 4) != 0 ||
+	    !read_u32(f, &start_id) || !read_u32(f, &nr_ids) ||
+	    !read_u32(f, &start_line) || fread(end_pos, sizeof(*end_pos), 1, f) != 1 ||
+	    (option_info && start_id != get_return_id()) ||
+	    !check_deps(f)) {
+		fclose(f);
+		stat_stale++;
+		return 0;
+	}
+
+	for (i = 0; i < nr; i++) {
+		buf[i] = NULL;
+		size[i] = 0;
+	}
+	for (i = 0; i < nr; i++) {
+		if (!read_u32(f, &len))
+			goto bad;
+		buf[i] = malloc(len + 1);
+		size[i] = len;
+		if (fread(buf[i], 1, len, f) != len)
+			goto bad;
+	}
+	fclose(f);
+
+	/* the body hash matched so the function is the same number of lines */
+	delta = sym->pos.line - start_line;
+	if (delta) {
+		end_line = get_cache_func(sym)->end_line - delta;
+		for (i = 0; i < nr; i++)
+			move_lines(&buf[i], &size[i], start_line, end_line, delta);
+		end_pos->line += delta;
+	}
+	/* the return_ids are printed with --info */
+	set_return_id(get_return_id() + nr_ids);
+	stat_hits++;
+	return 1;
+bad:
+	for (i = 0; i < nr; i++)
+		free(buf[i]);
+	fclose(f);
+	stat_stale++;
+	return 0;
+}
+
+void function_cache_start(struct symbol *sym)
+{
+	if (!option_function_cache)
+		return;
+	recording = sym;
+	recording_ok = !first_in_file;
+	first_in_file = 0;
+	start_return_id = get_return_id();
+	deps_seen = create_function_hashtable(1000);
+}
+
+static void save_entry(struct symbol *sym, char **buf, size_t *size, int nr,
+		       struct position end_pos)
+{
+	struct cache_query *query;
+	struct cache_inline *dep;
+	char name[PATH_MAX];
+	char tmp[PATH_MAX + 32];
+	FILE *f;
+	int i;
+
+	if (!get_cache_file(sym, name, sizeof(name)))
+		return;
+	snprintf(tmp, sizeof(tmp), "%s.%d", name, getpid());
+	f = fopen(tmp, "w");
+	if (!f)
+		return;
+
+	fwrite(CACHE_MAGIC, 4, 1, f);
+	write_u32(f, start_return_id);
+	write_u32(f, get_return_id() - start_return_id);
+	write_u32(f, sym->pos.line);
+	fwrite(&end_pos, sizeof(end_pos), 1, f);
+	write_u32(f, ptr_list_size((struct ptr_list *)deps) +
+		     ptr_list_size((struct ptr_list *)sticky_queries));
+	write_u32(f, ptr_list_size((struct ptr_list *)inline_deps));
+	FOR_EACH_PTR(deps, query) {
+		write_string(f, query->sql);
+		fwrite(&query->hash, sizeof(query->hash), 1, f);
+	} END_FOR_EACH_PTR(query);
+	FOR_EACH_PTR(sticky_queries, query) {
+		write_string(f, query->sql);
+		fwrite(&query->hash, sizeof(query->hash), 1, f);
+	} END_FOR_EACH_PTR(query);
+	FOR_EACH_PTR(inline_deps, dep) {
+		write_string(f, dep->name);
+		fwrite(&dep->hash, sizeof(dep->hash), 1, f);
+	} END_FOR_EACH_PTR(dep);
+	for (i = 0; i < nr; i++) {
+		write_u32(f, size[i]);
+		fwrite(buf[i], 1, size[i], f);
+	}
+
+	if (fclose(f) == 0 && rename(tmp, name) == 0)
+		stat_saved++;
+	else
+		unlink(tmp);
+}
+
+void function_cache_end(struct symbol *sym, char **buf, size_t *size, int nr,
+			struct position end_pos)
+{
+	if (!option_function_cache || !recording)
+		return;
+
+	if (recording_ok && !parse_error)
+		save_entry(sym, buf, size, nr, end_pos);
+	else
+		stat_uncacheable++;
+
+	recording = NULL;
+	free_queries(&deps);
+	free_inline_deps();
+	hashtable_destroy(deps_seen, 0);
+	deps_seen = NULL;
+}
+
+void function_cache_print_stats(void)
+{
+	if (!option_function_cache)
+		return;
+	sm_msg("function_cache: hits=%d misses=%d stale=%d saved=%d uncacheable=%d",
+	       stat_hits, stat_misses, stat_stale, stat_saved, stat_uncacheable);
+}
@@ -63,7 +63,7 @@ struct return_implies_callback {
 };
 ALLOCATOR(return_implies_callback, "return_implies callbacks");
 DECLARE_PTR_LIST(db_implies_list, struct return_implies_callback);
-static struct db_implies_list *db_return_states_list;
+static struct db_implies_list *db_return_states_list[INFO_TYPE_MAX];
 
 typedef void (void_fn)(void);
 DECLARE_PTR_LIST(void_fn_list, void_fn *);
@@ -141,9 +141,13 @@ void select_return_states_hook(int type, return_implies_hook *callback)
 {
 	struct return_implies_callback *cb = __alloc_return_implies_callback(0);
 
+	if (type < 0 || type >= INFO_TYPE_MAX) {
+		printf("FATAL ERROR: info type %d is out of range\n", type);
+		exit(1);
+	}
 	cb->type = type;
 	cb->callback = callback;
-	add_ptr_list(&db_return_states_list, cb);
+	add_ptr_list(&db_return_states_list[type], cb);
 }
 
 void select_return_states_before(void_fn *fn)
@@ -342,7 +346,7 @@ struct db_callback_info {
 	struct range_list *rl;
 	int left;
 	struct stree *stree;
-	struct db_implies_list *callbacks;
+	struct db_implies_list **callbacks;
 	int prev_return_id;
 	int cull;
 	int has_states;
@@ -569,10 +573,11 @@ static int db_compare_callback(void *_info, int argc, char **argv, char **azColN
 		__add_return_to_param_mapping(db_info->expr, argv[1]);
 	}
 
-	FOR_EACH_PTR(db_info->callbacks, tmp) {
-		if (tmp->type == type)
+	if (type >= 0 && type < INFO_TYPE_MAX) {
+		FOR_EACH_PTR(db_info->callbacks[type], tmp) {
 			tmp->callback(db_info->expr, param, key, value);
-	} END_FOR_EACH_PTR(tmp);
+		} END_FOR_EACH_PTR(tmp);
+	}
 
 	store_return_state(db_info, alloc_estate_rl(clone_rl(var_rl)));
 	return 0;
@@ -814,10 +819,11 @@ static int db_assign_return_states_callback(void *_info, int argc, char **argv,
 		__add_return_to_param_mapping(db_info->expr, argv[1]);
 	}
 
-	FOR_EACH_PTR(db_return_states_list, tmp) {
-		if (tmp->type == type)
+	if (type >= 0 && type < INFO_TYPE_MAX) {
+		FOR_EACH_PTR(db_return_states_list[type], tmp) {
 			tmp->callback(db_info->expr, param, key, value);
-	} END_FOR_EACH_PTR(tmp);
+		} END_FOR_EACH_PTR(tmp);
+	}
 	store_return_state(db_info, alloc_estate_rl(ret_range));
 
 	return 0;
@@ -994,10 +1000,11 @@ static int db_return_states_callback(void *_info, int argc, char **argv, char **
 	}
 
 
-	FOR_EACH_PTR(db_return_states_list, tmp) {
-		if (tmp->type == type)
+	if (type >= 0 && type < INFO_TYPE_MAX) {
+		FOR_EACH_PTR(db_return_states_list[type], tmp) {
 			tmp->callback(db_info->expr, param, key, value);
-	} END_FOR_EACH_PTR(tmp);
+		} END_FOR_EACH_PTR(tmp);
+	}
 
 	/*
 	 * We want to store the return values so that we can split the strees
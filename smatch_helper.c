@@ -28,6 +28,10 @@
 
 #define VAR_LEN 512
 
+/*
+ * The caller has to free_string() this.  Strings which only have to last
+ * until the end of the function should use alloc_sname() instead.
+ */
 char *alloc_string(const char *str)
 {
 	char *tmp;
@@ -67,7 +71,7 @@ struct smatch_state *alloc_state_num(int num)
 	state = __alloc_smatch_state(0);
 	snprintf(buff, 255, "%d", num);
 	buff[255] = '\0';
-	state->name = alloc_string(buff);
+	state->name = alloc_sname(buff);
 	state->data = INT_PTR(num);
 	return state;
 }
@@ -77,7 +81,7 @@ struct smatch_state *alloc_state_str(const char *name)
 	struct smatch_state *state;
 
 	state = __alloc_smatch_state(0);
-	state->name = alloc_string(name);
+	state->name = alloc_sname(name);
 	return state;
 }
 
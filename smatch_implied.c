@@ -61,6 +61,7 @@
 #include "smatch.h"
 #include "smatch_slist.h"
 #include "smatch_extra.h"
+#include "cwchash/hashtable.h"
 
 char *implied_debug_msg;
 #define DIMPLIED(msg...) do { if (option_debug_implied || option_debug) printf(msg); } while (0)
@@ -151,9 +152,11 @@ static int create_fake_history(struct sm_state *sm, int comparison, struct range
 
 	true_sm->state = alloc_estate_rl(cast_rl(estate_type(sm->state), true_rl));
 	free_slist(&true_sm->possible);
+	true_sm->nr_possible = 0;
 	add_possible_sm(true_sm, true_sm);
 	false_sm->state = alloc_estate_rl(cast_rl(estate_type(sm->state), false_rl));
 	free_slist(&false_sm->possible);
+	false_sm->nr_possible = 0;
 	add_possible_sm(false_sm, false_sm);
 
 	true_stree = clone_stree(sm->pool);
@@ -392,6 +395,67 @@ static int sm_in_keep_leafs(struct sm_state *sm, const struct state_list *keep_g
 	return 0;
 }
 
+/*
+ * The left and right histories of a merged state share a lot of the same
+ * sm_states.  When a function has many conditions in a row the same
+ * sub-history is reached through an exponential number of paths so
+ * filter_pools() remembers what it returned for each sm_state.  It's only
+ * for one call because the answer depends on the stacks.  With the debug
+ * options the memo is turned off so that every step is printed.
+ */
+struct filter_memo {
+	struct sm_state *sm;
+	struct sm_state *ret;
+	int modified;
+};
+
+static unsigned int filter_memo_hash(void *key)
+{
+	return (unsigned long)((struct filter_memo *)key)->sm >> 4;
+}
+
+static int filter_memo_equal(void *a, void *b)
+{
+	return ((struct filter_memo *)a)->sm == ((struct filter_memo *)b)->sm;
+}
+
+static DEFINE_HASHTABLE_INSERT(insert_filter_memo, struct filter_memo, struct filter_memo);
+static DEFINE_HASHTABLE_SEARCH(search_filter_memo, struct filter_memo, struct filter_memo);
+
+static struct sm_state *__filter_pools(struct sm_state *sm,
+				       const struct state_list *remove_stack,
+				       const struct state_list *keep_stack,
+				       int *modified, struct hashtable *memo);
+
+static struct sm_state *filter_pools_memo(struct sm_state *sm,
+					  const struct state_list *remove_stack,
+					  const struct state_list *keep_stack,
+					  int *modified, struct hashtable *memo)
+{
+	struct filter_memo key;
+	struct filter_memo *found;
+	int removed = 0;
+
+	if (!sm)
+		return NULL;
+	if (!memo)
+		return __filter_pools(sm, remove_stack, keep_stack, modified, NULL);
+
+	key.sm = sm;
+	found = search_filter_memo(memo, &key);
+	if (!found) {
+		found = malloc(sizeof(*found));
+		found->sm = sm;
+		found->ret = __filter_pools(sm, remove_stack, keep_stack, &removed, memo);
+		found->modified = removed;
+		/* the memo owns the key and the key is the value */
+		insert_filter_memo(memo, found, found);
+	}
+	if (found->modified)
+		*modified = 1;
+	return found->ret;
+}
+
 /*
  * NOTE: If a state is in both the keep stack and the remove stack then it is
  * removed.  If that happens it means you have a bug.  Only add states which are
@@ -400,10 +464,10 @@ static int sm_in_keep_leafs(struct sm_state *sm, const struct state_list *keep_g
  * and one side is false.  Otherwise, if you can't do that, then don't add it to
  * either list, and it will be treated as true.
  */
-struct sm_state *filter_pools(struct sm_state *sm,
-			      const struct state_list *remove_stack,
-			      const struct state_list *keep_stack,
-			      int *modified)
+static struct sm_state *__filter_pools(struct sm_state *sm,
+				       const struct state_list *remove_stack,
+				       const struct state_list *keep_stack,
+				       int *modified, struct hashtable *memo)
 {
 	struct sm_state *ret = NULL;
 	struct sm_state *left;
@@ -442,8 +506,8 @@ struct sm_state *filter_pools(struct sm_state *sm,
 		 show_sm(sm), sm->line, sm->nr_children,
 		 sm->left ? sm->left->state->name : "<none>", sm->left ? get_stree_id(sm->left->pool) : -1,
 		 sm->right ? sm->right->state->name : "<none>", sm->right ? get_stree_id(sm->right->pool) : -1);
-	left = filter_pools(sm->left, remove_stack, keep_stack, &removed);
-	right = filter_pools(sm->right, remove_stack, keep_stack, &removed);
+	left = filter_pools_memo(sm->left, remove_stack, keep_stack, &removed, memo);
+	right = filter_pools_memo(sm->right, remove_stack, keep_stack, &removed, memo);
 	if (!removed) {
 		DIMPLIED("kept [stree %d] %s from %d\n", get_stree_id(sm->pool), show_sm(sm), sm->line);
 		return sm;
@@ -485,6 +549,23 @@ struct sm_state *filter_pools(struct sm_state *sm,
 	return ret;
 }
 
+struct sm_state *filter_pools(struct sm_state *sm,
+			      const struct state_list *remove_stack,
+			      const struct state_list *keep_stack,
+			      int *modified)
+{
+	struct hashtable *memo;
+	struct sm_state *ret;
+
+	if (option_debug || option_debug_implied)
+		return __filter_pools(sm, remove_stack, keep_stack, modified, NULL);
+
+	memo = create_hashtable(64, filter_memo_hash, filter_memo_equal);
+	ret = __filter_pools(sm, remove_stack, keep_stack, modified, memo);
+	hashtable_destroy(memo, 0);
+	return ret;
+}
+
 static struct stree *filter_stack(struct sm_state *gate_sm,
 				       struct stree *pre_stree,
 				       const struct state_list *remove_stack,
@@ -560,6 +641,7 @@ static void separate_and_filter(struct sm_state *sm, int comparison, struct rang
 		__print_stree(*false_states);
 	}
 
+	cost_stats_implied(&time_before);
 	gettimeofday(&time_after, NULL);
 	if (time_after.tv_sec - time_before.tv_sec > 20) {
 		sm->nr_children = 4000;
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * With --info-frames=<file> the "SQL:" and "SQL_caller_info:" lines from
+ * --info are written to <file> as binary blocks instead of as text.  The
+ * text repeats the file and function name two times on every row.  Here
+ * they are written once when the function changes.
+ *
+ * Each block is:
+ *
+ *	"SMIF" flags raw_len len <len bytes of data>
+ *
+ * The three numbers are 32 bit little endian.  If bit 0 of flags is set then
+ * the data is zlib compressed and raw_len is the uncompressed size.  The
+ * data is a list of records:
+ *
+ *	'F' file '\0' function '\0'	the file and function for what follows
+ *	'S' line table '\0' values '\0'	SQL: insert into <table> values(...);
+ *	'I' line table '\0' values '\0'	SQL: insert or ignore into ...
+ *	'C' line values '\0'		SQL_caller_info: insert into caller_info ...
+ *
+ * "line" is a LEB128 number.  If values starts with a 0x01 byte then that
+ * stands for "'<file>', '<function>'" which is how most rows start.
+ *
+ * Every block starts with an 'F' record and blocks are only ended between
+ * functions so they can be decoded on their own.  Each block is appended
+ * with a single write() so several smatch processes can share one file.
+ * smatch_data/db/decode_info_frames.py turns the file back into the text
+ * that the smatch_data/db/ scripts expect.
+ */
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <unistd.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "smatch.h"
+
+#define FRAMES_MAGIC "SMIF"
+#define FRAMES_ZLIB 1
+#define BLOCK_SIZE (1024 * 1024)
+#define FILE_FUNC_MARK 0x01
+
+char *option_info_frames;
+
+static int frames_fd = -1;
+static char *block;
+static size_t block_len;
+static size_t block_size;
+static char *cur_file;
+static char *cur_func;
+static char *cur_prefix;
+static int cur_prefix_len;
+
+static void grow_block(size_t len)
+{
+	if (block_len + len <= block_size)
+		return;
+	while (block_len + len > block_size)
+		block_size = block_size ? block_size * 2 : BLOCK_SIZE * 2;
+	block = realloc(block, block_size);
+	if (!block) {
+		printf("Error:  out of memory for --info-frames\n");
+		exit(1);
+	}
+}
+
+static void add_bytes(const void *data, size_t len)
+{
+	grow_block(len);
+	memcpy(block + block_len, data, len);
+	block_len += len;
+}
+
+static void add_string(const char *str)
+{
+	add_bytes(str, strlen(str) + 1);
+}
+
+static void add_varint(unsigned int val)
+{
+	unsigned char c;
+
+	do {
+		c = val & 0x7f;
+		val >>= 7;
+		if (val)
+			c |= 0x80;
+		add_bytes(&c, 1);
+	} while (val);
+}
+
+static void put_le32(unsigned char *p, unsigned int val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+	p[2] = val >> 16;
+	p[3] = val >> 24;
+}
+
+static void write_all(const unsigned char *data, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = write(frames_fd, data, len);
+		if (ret < 0) {
+			printf("Error:  writing %s failed\n", option_info_frames);
+			exit(1);
+		}
+		data += ret;
+		len -= ret;
+	}
+}
+
+static void write_block(void)
+{
+	unsigned char *out;
+	unsigned long len = block_len;
+	unsigned int flags = 0;
+
+	out = malloc(16 + block_len);
+	if (!out) {
+		printf("Error:  out of memory for --info-frames\n");
+		exit(1);
+	}
+	memcpy(out + 16, block, block_len);
+#ifdef HAVE_ZLIB
+	{
+		unsigned long zlen = compressBound(block_len);
+		unsigned char *zout = malloc(16 + zlen);
+
+		if (zout && compress2(zout + 16, &zlen, (unsigned char *)block,
+				      block_len, 1) == Z_OK && zlen < block_len) {
+			free(out);
+			out = zout;
+			len = zlen;
+			flags |= FRAMES_ZLIB;
+		} else {
+			free(zout);
+		}
+	}
+#endif
+	memcpy(out, FRAMES_MAGIC, 4);
+	put_le32(out + 4, flags);
+	put_le32(out + 8, block_len);
+	put_le32(out + 12, len);
+	write_all(out, 16 + len);
+	free(out);
+}
+
+void info_frames_flush(void)
+{
+	if (block_len)
+		write_block();
+	block_len = 0;
+	/* the next block has to say which function it's in again */
+	free(cur_file);
+	free(cur_func);
+	cur_file = NULL;
+	cur_func = NULL;
+}
+
+static void open_frames_file(void)
+{
+	if (frames_fd >= 0)
+		return;
+	frames_fd = open(option_info_frames, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (frames_fd < 0) {
+		printf("Error:  Cannot open %s\n", option_info_frames);
+		exit(1);
+	}
+}
+
+static void set_cur_function(void)
+{
+	const char *file = get_filename();
+	const char *func = get_function();
+	char buf[512];
+
+	/* this matches what printf() does for sm_prefix() */
+	if (!func)
+		func = "(null)";
+
+	if (cur_file && strcmp(cur_file, file) == 0 &&
+	    cur_func && strcmp(cur_func, func) == 0)
+		return;
+
+	/* only end blocks between functions so the caller_info rows stay together */
+	if (block_len >= BLOCK_SIZE)
+		info_frames_flush();
+
+	free(cur_file);
+	free(cur_func);
+	free(cur_prefix);
+	cur_file = alloc_string(file);
+	cur_func = alloc_string(func);
+	snprintf(buf, sizeof(buf), "'%s', '%s'", file, func);
+	cur_prefix = alloc_string(buf);
+	cur_prefix_len = strlen(cur_prefix);
+
+	add_bytes("F", 1);
+	add_string(file);
+	add_string(func);
+}
+
+static void add_values(const char *fmt, va_list args)
+{
+	va_list copy;
+	size_t room;
+	char *start;
+	int len;
+
+	grow_block(256);
+	room = block_size - block_len;
+	va_copy(copy, args);
+	len = vsnprintf(block + block_len, room, fmt, copy);
+	va_end(copy);
+	if (len < 0)
+		len = 0;
+	if (len >= room) {
+		grow_block(len + 1);
+		vsnprintf(block + block_len, len + 1, fmt, args);
+	}
+
+	start = block + block_len;
+	if (strncmp(start, cur_prefix, cur_prefix_len) == 0) {
+		start[0] = FILE_FUNC_MARK;
+		memmove(start + 1, start + cur_prefix_len, len - cur_prefix_len + 1);
+		len -= cur_prefix_len - 1;
+	}
+	block_len += len + 1;
+}
+
+static int printing(void)
+{
+	return final_pass || option_debug || local_debug;
+}
+
+void info_frames_sql(const char *table, int ignore, const char *fmt, ...)
+{
+	va_list args;
+
+	if (!printing())
+		return;
+	open_frames_file();
+	set_cur_function();
+
+	add_bytes(ignore ? "I" : "S", 1);
+	add_varint(get_lineno());
+	add_string(table);
+	va_start(args, fmt);
+	add_values(fmt, args);
+	va_end(args);
+}
+
+void info_frames_caller_info(const char *fmt, ...)
+{
+	va_list args;
+
+	if (!printing())
+		return;
+	open_frames_file();
+	set_cur_function();
+
+	add_bytes("C", 1);
+	add_varint(get_lineno());
+	va_start(args, fmt);
+	add_values(fmt, args);
+	va_end(args);
+}
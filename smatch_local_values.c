@@ -19,6 +19,7 @@
 #include "smatch.h"
 #include "smatch_slist.h"
 #include "smatch_extra.h"
+#include "smatch_function_hashtable.h"
 
 static int my_id;
 
@@ -27,10 +28,22 @@ static int my_id;
  * Then at the end of the file, I'll combine the possible range lists for
  * each state and store the value in the on-disk database.
  *
- * One issue is that when I read the data back from the in-memory database at
- * the end of the file, then I don't have access to type information.  I'll just
- * cast everything to "long long" for now, I guess.  We'll see how that works.
+ * The values are kept in a hash of variable name -> struct local_value for
+ * the file.  Everything is cast to "long long" because variables with the same
+ * name are combined and they might not have the same type.
  */
+struct local_value {
+	char *name;
+	struct symbol *sym;
+	struct range_list *rl;
+};
+ALLOCATOR(local_value, "local values");
+DECLARE_PTR_LIST(local_value_list, struct local_value);
+
+static DEFINE_HASHTABLE_INSERT(insert_local_value, char, struct local_value);
+static DEFINE_HASHTABLE_SEARCH(search_local_value, char, struct local_value);
+static struct hashtable *local_value_hash;
+static struct local_value_list *local_value_list;
 
 static char *db_vals;
 static int get_vals(void *unused, int argc, char **argv, char **azColName)
@@ -120,6 +133,34 @@ static void extra_mod_hook(const char *name, struct symbol *sym, struct smatch_s
 	set_state(my_id, name, sym, new);
 }
 
+static void add_local_value(const char *name, struct symbol *sym, struct range_list *rl)
+{
+	struct local_value *val;
+	struct range_list *new;
+
+	/* the values are printed at the end of the file */
+	function_cache_uncacheable();
+
+	if (!local_value_hash)
+		local_value_hash = create_function_hashtable(1000);
+
+	val = search_local_value(local_value_hash, (char *)name);
+	if (!val) {
+		val = __alloc_local_value(0);
+		val->name = alloc_string(name);
+		val->sym = sym;
+		val->rl = clone_rl_permanent(rl);
+		insert_local_value(local_value_hash, val->name, val);
+		add_ptr_list(&local_value_list, val);
+		return;
+	}
+
+	/* the ranges are permanent so only copy them when they change */
+	new = rl_union(val->rl, rl);
+	if (!rl_equiv(new, val->rl))
+		val->rl = clone_rl_permanent(new);
+}
+
 static void process_states(void)
 {
 	struct sm_state *sm;
@@ -135,10 +176,7 @@ static void process_states(void)
 		else
 			rl = estate_rl(sm->state);
 		rl = cast_rl(&llong_ctype, rl);
-		mem_sql(NULL, NULL,
-			"insert into local_values values ('%s', '%s', '%s', %lu);",
-			get_filename(), sm->name, show_rl(rl),
-			(unsigned long)sm->sym);
+		add_local_value(sm->name, sm->sym, rl);
 	} END_FOR_EACH_SM(sm);
 }
 
@@ -175,56 +213,50 @@ static int get_initial_value_sym(struct symbol *sym, char *name, sval_t *sval)
 	return 0;
 }
 
-static char *cur_name;
-static struct symbol *cur_symbol;
-static struct range_list *cur_rl;
-static void add_current_local(void)
+static void save_local_value(struct local_value *val)
 {
+	struct range_list *rl;
 	sval_t initial;
 
-	if (!get_initial_value_sym(cur_symbol, cur_name, &initial)) {
-		free_string(cur_name);
-		cur_name = NULL;
-		cur_rl = NULL;
+	if (!get_initial_value_sym(val->sym, val->name, &initial))
+		return;
+	rl = clone_rl(val->rl);
+	add_range(&rl, initial, initial);
+	/* merge_function_shards.py joins the ranges from every shard */
+	if (function_shard_mode()) {
+		fprintf(sm_outfd, "smatch_shard: local_value|%s|%s|%s|%s\n",
+			val->name, sval_to_str(sval_type_min(rl_type(rl))),
+			sval_to_str(sval_type_max(rl_type(rl))), show_rl(rl));
 		return;
 	}
-	add_range(&cur_rl, initial, initial);
-	if (!is_whole_rl(cur_rl))
-		sql_insert_local_values(cur_name, show_rl(cur_rl));
-	free_string(cur_name);
-	cur_name = NULL;
-	cur_rl = NULL;
+	if (!is_whole_rl(rl))
+		sql_insert_local_values(val->name, show_rl(rl));
 }
 
-static int save_final_values(void *unused, int argc, char **argv, char **azColName)
+static int cmp_local_value(const void *_a, const void *_b)
 {
-	char *name = argv[0];
-	char *sym_str = argv[1];
-	char *value = argv[2];
-	struct range_list *rl;
+	const struct local_value *a = _a;
+	const struct local_value *b = _b;
 
-	if (!cur_name) {
-		cur_name = alloc_string(name);
-		cur_symbol = (struct symbol *)strtoul(sym_str, NULL, 10);
-	} else if (strcmp(cur_name, name) != 0) {
-		add_current_local();
-		cur_name = alloc_string(name);
-		cur_symbol = (struct symbol *)strtoul(sym_str, NULL, 10);
-		cur_rl = NULL;
-	}
-
-	str_to_rl(&llong_ctype, value, &rl);
-	cur_rl = rl_union(cur_rl, rl);
-
-	return 0;
+	return strcmp(a->name, b->name);
 }
 
 static void match_end_file(struct symbol_list *sym_list)
 {
-	mem_sql(save_final_values, NULL,
-		"select distinct variable, symbol, value from local_values order by variable;");
-	if (cur_name)
-		add_current_local();
+	struct local_value *val;
+
+	if (function_shard_mode())
+		fprintf(sm_outfd, "smatch_shard: local_values\n");
+	sort_list((struct ptr_list **)&local_value_list, cmp_local_value);
+	FOR_EACH_PTR(local_value_list, val) {
+		save_local_value(val);
+	} END_FOR_EACH_PTR(val);
+
+	if (local_value_hash)
+		destroy_function_hashtable(local_value_hash);
+	local_value_hash = NULL;
+	free_ptr_list(&local_value_list);
+	clear_local_value_alloc();
 }
 
 void register_local_values(int id)
@@ -239,5 +271,4 @@ void register_local_values(int id)
 	add_merge_hook(my_id, &merge_estates);
 	all_return_states_hook(&process_states);
 	add_hook(match_end_file, END_FILE_HOOK);
-	mem_sql(NULL, NULL, "alter table local_values add column symbol integer;");
 }
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * The --mem-stats option prints how much memory each allocator used for
+ * every function, a per allocator summary for the file and the functions
+ * which used the most memory.  Everything is printed on "mem_stats:" lines
+ * with '|' separated fields so that it's easy to parse:
+ *
+ * mem_stats: function|file|func|allocator|allocations|bytes|useful_bytes
+ * mem_stats: allocator|allocator|allocations|bytes|useful_bytes|peak_bytes|usage_percent
+ * mem_stats: top|rank|file|func|bytes
+ * mem_stats: db_cache|table|rows|bytes|usecs
+ *
+ * "bytes" is what was taken from the system in chunks and "useful_bytes" is
+ * what was actually asked for.  Most of the per function memory is thrown
+ * away at the end of the function so "bytes" is also the peak for that
+ * function.
+ *
+ * The "db_cache" lines are printed when one of the small DB tables is
+ * loaded into memory.  Their "bytes" is an estimate of the strings, entries
+ * and range lists held by the cache.
+ */
+
+#include "smatch.h"
+
+int option_mem_stats;
+
+struct alloc_stat {
+	struct allocator_struct *desc;
+	unsigned int start_allocations, start_bytes, start_useful;
+	unsigned long long allocations, bytes, useful;
+	unsigned int peak;
+};
+
+static struct alloc_stat *stats;
+static int nr_stats;
+
+struct top_func {
+	char *file;
+	char *func;
+	unsigned long long bytes;
+};
+
+static struct top_func *top;
+static int nr_top;
+
+static struct alloc_stat *get_alloc_stat(struct allocator_struct *desc)
+{
+	int i;
+
+	for (i = 0; i < nr_stats; i++) {
+		if (stats[i].desc == desc)
+			return &stats[i];
+	}
+	stats = realloc(stats, (nr_stats + 1) * sizeof(*stats));
+	if (!stats)
+		die("out of memory");
+	memset(&stats[nr_stats], 0, sizeof(*stats));
+	stats[nr_stats].desc = desc;
+	return &stats[nr_stats++];
+}
+
+void mem_stats_start_function(void)
+{
+	struct allocator_struct *desc;
+	struct alloc_stat *stat;
+
+	if (!option_mem_stats)
+		return;
+
+	for (desc = all_allocators; desc; desc = desc->next_allocator) {
+		stat = get_alloc_stat(desc);
+		stat->start_allocations = desc->allocations;
+		stat->start_bytes = desc->total_bytes;
+		stat->start_useful = desc->useful_bytes;
+	}
+}
+
+static void add_top_func(const char *func, unsigned long long bytes)
+{
+	int i;
+
+	if (!top) {
+		top = malloc(option_mem_stats * sizeof(*top));
+		if (!top)
+			die("out of memory");
+	}
+	if (nr_top == option_mem_stats && top[nr_top - 1].bytes >= bytes)
+		return;
+
+	if (nr_top < option_mem_stats) {
+		nr_top++;
+	} else {
+		free_string(top[nr_top - 1].file);
+		free_string(top[nr_top - 1].func);
+	}
+
+	i = nr_top - 1;
+	while (i > 0 && top[i - 1].bytes < bytes) {
+		top[i] = top[i - 1];
+		i--;
+	}
+	top[i].file = alloc_string(get_base_file());
+	top[i].func = alloc_string(func);
+	top[i].bytes = bytes;
+}
+
+void mem_stats_end_function(void)
+{
+	struct allocator_struct *desc;
+	struct alloc_stat *stat;
+	unsigned int allocations, bytes, useful;
+	unsigned long long func_bytes = 0;
+	const char *func;
+
+	if (!option_mem_stats)
+		return;
+
+	func = get_function();
+	if (!func)
+		func = "unknown";
+
+	for (desc = all_allocators; desc; desc = desc->next_allocator) {
+		stat = get_alloc_stat(desc);
+		/*
+		 * Some allocators are cleared in the middle of a function and
+		 * then we can only count what was allocated since.
+		 */
+		if (desc->total_bytes < stat->start_bytes ||
+		    desc->allocations < stat->start_allocations) {
+			stat->start_allocations = 0;
+			stat->start_bytes = 0;
+			stat->start_useful = 0;
+		}
+		allocations = desc->allocations - stat->start_allocations;
+		bytes = desc->total_bytes - stat->start_bytes;
+		useful = desc->useful_bytes - stat->start_useful;
+		if (!allocations && !bytes)
+			continue;
+
+		fprintf(sm_outfd, "mem_stats: function|%s|%s|%s|%u|%u|%u\n",
+			get_base_file(), func, desc->name, allocations, bytes,
+			useful);
+
+		stat->allocations += allocations;
+		stat->bytes += bytes;
+		stat->useful += useful;
+		if (bytes > stat->peak)
+			stat->peak = bytes;
+		func_bytes += bytes;
+	}
+
+	add_top_func(func, func_bytes);
+}
+
+void mem_stats_end_file(void)
+{
+	struct allocator_struct *desc;
+	struct alloc_stat *stat;
+	double usage;
+	int i;
+
+	if (!option_mem_stats)
+		return;
+
+	for (i = 0; i < nr_stats; i++) {
+		stat = &stats[i];
+		desc = stat->desc;
+		if (!stat->bytes)
+			continue;
+		/*
+		 * A function can fill up a chunk which was started by the
+		 * function before it so for the allocators which aren't reset
+		 * use their own totals to see how well the chunks are used.
+		 */
+		if (desc->total_bytes)
+			usage = 100 * (double)desc->useful_bytes / desc->total_bytes;
+		else
+			usage = 100 * (double)stat->useful / stat->bytes;
+		fprintf(sm_outfd, "mem_stats: allocator|%s|%llu|%llu|%llu|%u|%.2f\n",
+			desc->name, stat->allocations, stat->bytes,
+			stat->useful, stat->peak, usage);
+		stat->allocations = 0;
+		stat->bytes = 0;
+		stat->useful = 0;
+		stat->peak = 0;
+	}
+
+	for (i = 0; i < nr_top; i++) {
+		fprintf(sm_outfd, "mem_stats: top|%d|%s|%s|%llu\n", i + 1,
+			top[i].file, top[i].func, top[i].bytes);
+		free_string(top[i].file);
+		free_string(top[i].func);
+	}
+	nr_top = 0;
+}
+
+void mem_stats_db_cache(const char *table, int rows, unsigned long bytes,
+			struct timeval *start)
+{
+	struct timeval end;
+	long usecs;
+
+	if (!option_mem_stats)
+		return;
+
+	gettimeofday(&end, NULL);
+	usecs = (end.tv_sec - start->tv_sec) * 1000000L +
+		(end.tv_usec - start->tv_usec);
+	fprintf(sm_outfd, "mem_stats: db_cache|%s|%d|%lu|%ld\n",
+		table, rows, bytes, usecs);
+}
@@ -20,10 +20,12 @@
 #include "smatch_extra.h"
 #include "smatch_slist.h"
 
-ALLOCATOR(data_info, "smatch extra data");
-ALLOCATOR(data_range, "data range");
-__DO_ALLOCATOR(struct data_range, sizeof(struct data_range), __alignof__(struct data_range),
-			 "permanent ranges", perm_data_range);
+ARENA_ALLOCATOR(data_info, "smatch extra data", &function_arena);
+ARENA_ALLOCATOR(data_range, "data range", &function_arena);
+__DO_ARENA_ALLOCATOR(struct data_range, sizeof(struct data_range), __alignof__(struct data_range),
+			 "permanent ranges", perm_data_range, &perm_arena);
+__DO_ARENA_ALLOCATOR(struct data_info, sizeof(struct data_info), __alignof__(struct data_info),
+			 "permanent extra data", perm_data_info, &perm_arena);
 
 char *show_rl(struct range_list *list)
 {
@@ -1721,23 +1723,18 @@ static void free_dinfos(struct allocation_blob *blob)
 	}
 }
 
+/* the data_info structs themselves go when the function arena is reset */
 void free_data_info_allocs(void)
 {
-	struct allocator_struct *desc = &data_info_allocator;
-	struct allocation_blob *blob = desc->blobs;
+	struct allocation_blob *blob;
 
-	desc->blobs = NULL;
-	desc->allocations = 0;
-	desc->total_bytes = 0;
-	desc->useful_bytes = 0;
-	desc->freelist = NULL;
-	while (blob) {
-		struct allocation_blob *next = blob->next;
+	for (blob = data_info_allocator.blobs; blob; blob = blob->next)
 		free_dinfos(blob);
-		blob_free(blob, desc->chunking);
-		blob = next;
-	}
-	clear_data_range_alloc();
+}
+
+struct data_info *alloc_perm_dinfo(void)
+{
+	return __alloc_perm_data_info(0);
 }
 
 void split_comparison_rl(struct range_list *left_orig, int op, struct range_list *right_orig,
@@ -35,7 +35,10 @@ if [ ! -e smatch_db.sqlite ] ; then
     fi
 fi
 
-$SCRIPT_DIR/test_kernel.sh --call-tree --info --param-mapper --spammy --data=$DATA_DIR
+# the SQL goes to smatch_warns.txt.frames and create_db.sh decodes it
+rm -f smatch_warns.txt.frames
+$SCRIPT_DIR/test_kernel.sh --call-tree --info --param-mapper --spammy --data=$DATA_DIR \
+    --info-frames=$(pwd)/smatch_warns.txt.frames
 
 for i in $SCRIPT_DIR/gen_* ; do
 	$i smatch_warns.txt -p=kernel
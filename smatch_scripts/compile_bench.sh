@@ -0,0 +1,90 @@
+#!/bin/bash
+
+#
+# Times the i386 backend on the programs in smatch_scripts/compile_bench/.
+# For each program it prints how long ./compile took and how long the
+# generated code took to run, with and without -fno-regalloc.  The exit
+# value of every run is checked against "gcc -m32 -O0".
+#
+#   smatch_scripts/compile_bench.sh [n]
+#
+# This needs a 32-bit capable assembler and linker but no 32-bit libc.
+#
+
+N=${1:-100000}
+REPEAT=20
+DIR=$(dirname $0)/compile_bench
+COMPILE=$(dirname $0)/../compile
+TMP=$(mktemp -d)
+
+if [ "$1" = "-h" ] || [ "$1" = "--help" ] ; then
+    echo "Usage: $0 [n]"
+    exit 1
+fi
+
+trap "rm -rf $TMP" EXIT
+
+cat > $TMP/start.s <<EOF
+	.text
+	.globl _start
+_start:
+	pushl	\$$N
+	call	bench
+	addl	\$4, %esp
+	movl	%eax, %ebx
+	andl	\$255, %ebx
+	movl	\$1, %eax
+	int	\$0x80
+EOF
+as --32 $TMP/start.s -o $TMP/start.o || exit 1
+
+now()
+{
+    date +%s.%N
+}
+
+elapsed()
+{
+    awk -v start=$1 -v end=$2 -v n=${3:-1} 'BEGIN { printf "%.4f", (end - start) / n }'
+}
+
+run()
+{
+    local prog=$1
+    local start end
+
+    start=$(now)
+    $prog
+    RET=$?
+    end=$(now)
+    TIME=$(elapsed $start $end)
+}
+
+printf "%-10s %-10s %12s %12s\n" "program" "options" "compile(s)" "run(s)"
+for file in $DIR/*.c ; do
+    name=$(basename $file .c)
+
+    gcc -m32 -O0 -c $file -o $TMP/ref.o || exit 1
+    ld -m elf_i386 -z noexecstack $TMP/start.o $TMP/ref.o -o $TMP/ref || exit 1
+    run $TMP/ref
+    expected=$RET
+    printf "%-10s %-10s %12s %12s\n" $name "gcc -O0" "-" $TIME
+
+    for opt in -fno-regalloc -fregalloc ; do
+        start=$(now)
+        for i in $(seq $REPEAT) ; do
+            $COMPILE $opt $file > $TMP/$name.s 2> /dev/null
+        done
+        end=$(now)
+        compile_time=$(elapsed $start $end $REPEAT)
+
+        as --32 $TMP/$name.s -o $TMP/$name.o || exit 1
+        ld -m elf_i386 -z noexecstack $TMP/start.o $TMP/$name.o -o $TMP/$name || exit 1
+        run $TMP/$name
+        printf "%-10s %-10s %12s %12s" $name $opt $compile_time $TIME
+        if [ $RET != $expected ] ; then
+            printf "  wrong result %d, expected %d" $RET $expected
+        fi
+        printf "\n"
+    done
+done
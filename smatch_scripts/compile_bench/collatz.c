@@ -0,0 +1,25 @@
+/* divides and branches */
+int steps(int x)
+{
+	int count;
+
+	count = 0;
+	while (x != 1) {
+		if (x % 2)
+			x = 3 * x + 1;
+		else
+			x = x / 2;
+		count++;
+	}
+	return count;
+}
+
+int bench(int n)
+{
+	int i, total;
+
+	total = 0;
+	for (i = 1; i < n; i++)
+		total = total + steps(i);
+	return total;
+}
@@ -0,0 +1,17 @@
+/* calls */
+int fib(int n)
+{
+	if (n < 2)
+		return n;
+	return fib(n - 1) + fib(n - 2);
+}
+
+int bench(int n)
+{
+	int i, r;
+
+	r = 0;
+	for (i = 0; i < n / 1000; i++)
+		r = r + fib(20);
+	return r;
+}
@@ -0,0 +1,31 @@
+/* a loop with lots of live values */
+int gcd(int a, int b)
+{
+	int t;
+
+	while (b) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+int bench(int n)
+{
+	int a, b, c, d, i, r;
+
+	r = 0;
+	a = 1;
+	b = 2;
+	c = 3;
+	d = 5;
+	for (i = 1; i < n * 2; i++) {
+		a = a + i;
+		b = b + a;
+		c = c + b;
+		d = d + c;
+		r = r + gcd(i, 3 * i + 12) + (a ^ b) - (c & d);
+	}
+	return r;
+}
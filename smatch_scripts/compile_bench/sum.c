@@ -0,0 +1,13 @@
+/* nested loops over a running sum */
+int bench(int n)
+{
+	int i, j, s;
+
+	s = 0;
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < 100; j++)
+			s = s + i * 3 + j;
+		s = s ^ i;
+	}
+	return s;
+}
@@ -0,0 +1,127 @@
+#!/usr/bin/python3
+
+#
+# Runs a command on a list of files, most expensive file first, using the
+# "cost: file|..." lines which "smatch --cost-stats" printed last time.
+#
+# Starting the slow files first means the run doesn't end with a few big
+# files still going after everything else is done.  Files which weren't in
+# the last run are given the average cost.
+#
+# Usage:  cost_schedule.py [--jobs=<n>] [--costs=<file>]... [--print] \
+#             --cmd="<command>" [file.c...]
+#
+# The command is run through the shell with the file name added to the end.
+# If no files are given they are read from stdin, one per line.  --print
+# only prints the order and the estimated times.
+#
+
+import heapq
+import os
+import subprocess
+import sys
+import time
+
+def usage():
+    print("Usage:  %s [--jobs=<n>] [--costs=<file>]... [--print] --cmd=\"<command>\" [file.c...]" % sys.argv[0])
+    sys.exit(1)
+
+def read_costs(names):
+    costs = {}
+    for name in names:
+        try:
+            f = open(name, errors="replace")
+        except IOError:
+            sys.stderr.write("warning: cannot open %s\n" % name)
+            continue
+        for line in f:
+            if not line.startswith("cost: file|"):
+                continue
+            fields = line.rstrip("\n").split("|")
+            if len(fields) < 3:
+                continue
+            try:
+                usecs = int(fields[2])
+            except ValueError:
+                continue
+            # the last run of a file wins
+            costs[os.path.normpath(fields[1])] = usecs / 1000000.0
+        f.close()
+    return costs
+
+def estimate_makespan(costs, jobs):
+    workers = [0.0] * jobs
+    for cost in costs:
+        heapq.heapreplace(workers, workers[0] + cost)
+    return max(workers)
+
+def run(cmd, files, jobs):
+    running = {}
+    todo = list(files)
+    failed = 0
+
+    while todo or running:
+        while todo and len(running) < jobs:
+            name = todo.pop(0)
+            proc = subprocess.Popen("%s %s" % (cmd, name), shell=True)
+            running[proc.pid] = proc
+        pid, status = os.wait()
+        if pid not in running:
+            continue
+        del running[pid]
+        if status != 0:
+            failed += 1
+    return failed
+
+def main():
+    jobs = os.cpu_count() or 1
+    cost_files = []
+    cmd = None
+    print_only = False
+    files = []
+
+    for arg in sys.argv[1:]:
+        if arg.startswith("--jobs="):
+            jobs = max(1, int(arg[7:]))
+        elif arg.startswith("--costs="):
+            cost_files.append(arg[8:])
+        elif arg.startswith("--cmd="):
+            cmd = arg[6:]
+        elif arg == "--print":
+            print_only = True
+        elif arg.startswith("-"):
+            usage()
+        else:
+            files.append(arg)
+
+    if not cmd and not print_only:
+        usage()
+    if not files:
+        files = [line.strip() for line in sys.stdin if line.strip()]
+
+    costs = read_costs(cost_files)
+    known = [costs[os.path.normpath(f)] for f in files if os.path.normpath(f) in costs]
+    default = sum(known) / len(known) if known else 0.0
+
+    order = [(costs.get(os.path.normpath(f), default), f) for f in files]
+    # sort() is stable so files with the same cost keep their order
+    order.sort(key=lambda x: -x[0])
+
+    total = sum(cost for cost, name in order)
+    sys.stderr.write("cost_schedule: %d files, %d with costs, %.1fs of work, "
+                     "%d jobs, best %.1fs, estimated %.1fs\n" %
+                     (len(order), len(known), total, jobs, total / jobs,
+                      estimate_makespan([cost for cost, name in order], jobs)))
+
+    if print_only:
+        for cost, name in order:
+            print("%.3f %s" % (cost, name))
+        return 0
+
+    start = time.time()
+    failed = run(cmd, [name for cost, name in order], jobs)
+    sys.stderr.write("cost_schedule: done in %.1fs, %d failed\n" %
+                     (time.time() - start, failed))
+    return 1 if failed else 0
+
+sys.exit(main())
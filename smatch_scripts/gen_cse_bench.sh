@@ -0,0 +1,33 @@
+#!/bin/bash
+
+#
+# Prints a C file with a few huge functions full of common subexpressions
+# for timing the CSE pass:
+#
+#   smatch_scripts/gen_cse_bench.sh > cse_bench.c
+#   ./test-linearize --bench cse_bench.c
+#
+
+FUNCS=${1:-4}
+STMTS=${2:-20000}
+
+if [ "$1" = "-h" ] || [ "$1" = "--help" ] ; then
+    echo "Usage: $0 [functions] [statements per function]"
+    exit 1
+fi
+
+awk -v funcs=$FUNCS -v stmts=$STMTS 'BEGIN {
+	for (f = 0; f < funcs; f++) {
+		printf "int cse_bench%d(int a, int b, int c, int *p)\n{\n", f
+		printf "\tint r = 0;\n\n"
+		for (i = 0; i < stmts; i++) {
+			n = i % 1000
+			printf "\tr += (a + %d) * (b ^ %d) - (c << %d);\n", n, n, i % 31
+			if (i % 256 == 0)
+				printf "\tif (c > %d)\n\t\tr ^= (a + %d) * (b ^ %d);\n", n, n, n
+			if (i % 16 == 0)
+				printf "\tp[%d] = r + (a + %d);\n", n, n
+		}
+		printf "\treturn r;\n}\n\n"
+	}
+}'
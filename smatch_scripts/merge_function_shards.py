@@ -0,0 +1,258 @@
+#!/usr/bin/python3
+
+#
+# Puts the output of several "smatch --function-shard=<n>/<total>" or
+# "smatch --function-range=<start>:<count>" runs of the same file back
+# together in the order a single smatch run would print it.  See the
+# comment above split_c_file_functions() in smatch_flow.c for the format.
+#
+# Usage:  merge_function_shards.py <shard 0 output> <shard 1 output>...
+#
+# The file level output, the inline functions split at the end of the file
+# and the --time lines are taken from the first file.
+#
+
+import re
+import sys
+
+MARK = "smatch_shard: "
+RETURN_ID = re.compile(r"^(.* SQL: insert into return_states values\('[^']*', '[^']*', \d+, )(\d+)(,.*)$")
+
+class Unit:
+    def __init__(self, fields, shard, seq):
+        self.kind = fields[1]
+        self.idx = int(fields[2])
+        self.name = fields[3]
+        self.line = fields[4]
+        self.start = int(fields[5])
+        self.end = self.start
+        self.pos = None
+        self.shard = shard
+        self.seq = seq
+        self.lines = []
+
+    def key(self):
+        return "%s:%s" % (self.name, self.line)
+
+class File:
+    def __init__(self, fields):
+        self.name = fields[1]
+        self.nr = int(fields[2])
+        self.last_is_function = fields[3] == "1"
+        self.start = int(fields[4])
+        self.prologue = []
+        self.units = []
+        self.loop_end = None
+        self.end_file = None
+        self.epilogue = []
+        self.local_values = []
+
+def fatal(msg):
+    sys.stderr.write("merge_function_shards: %s\n" % msg)
+    sys.exit(1)
+
+def read_shard(name, shard):
+    files = []
+    pending = []
+    cur = None
+    unit = None
+    seq = 0
+
+    for line in open(name, errors="surrogateescape"):
+        line = line.rstrip("\n")
+        if not line.startswith(MARK):
+            if unit:
+                unit.lines.append(line)
+            elif cur and cur.end_file:
+                cur.epilogue.append(line)
+            elif cur and cur.units:
+                cur.units[-1].lines.append(line)
+            else:
+                pending.append(line)
+            continue
+
+        fields = line[len(MARK):].split("|")
+        kind = fields[0]
+        if kind == "file":
+            cur = File(fields)
+            cur.prologue = pending
+            pending = []
+            files.append(cur)
+        elif not cur:
+            fatal("%s: '%s' before the file marker" % (name, line))
+        elif kind == "unit":
+            unit = Unit(fields, shard, seq)
+            seq += 1
+        elif kind == "unit_end":
+            unit.end = int(fields[1])
+            unit.pos = (fields[2], fields[3])
+            cur.units.append(unit)
+            unit = None
+        elif kind == "loop_end":
+            cur.loop_end = (fields[1], fields[2])
+        elif kind == "end_file":
+            cur.end_file = (fields[2], fields[3])
+        elif kind == "local_values":
+            cur.epilogue.append(None)
+        elif kind == "local_value":
+            cur.local_values.append(fields[1:])
+        elif kind == "done":
+            cur = None
+        else:
+            fatal("%s: unknown marker '%s'" % (name, line))
+    return files, pending
+
+NAMED = {
+    "u64max": 2**64 - 1, "u32max": 2**32 - 1, "u16max": 2**16 - 1,
+    "s64max": 2**63 - 1, "s32max": 2**31 - 1, "s16max": 2**15 - 1,
+    "s64min": -2**63, "s32min": -2**31, "s16min": -2**15,
+}
+
+def parse_val(s):
+    if s in NAMED:
+        return NAMED[s]
+    if s.startswith("(") and s.endswith(")"):
+        s = s[1:-1]
+    return int(s)
+
+VALUE = r"(\(-\d+\)|-?\d+|[su]\d+(?:min|max))"
+RANGE = re.compile("^%s(?:-%s)?$" % (VALUE, VALUE))
+
+def parse_rl(rl):
+    ranges = []
+    for part in rl.split(","):
+        m = RANGE.match(part)
+        if not m:
+            return None
+        low = m.group(1)
+        high = m.group(2) or low
+        ranges.append([parse_val(low), low, parse_val(high), high])
+    return ranges
+
+def show_rl(ranges):
+    out = []
+    for low, low_str, high, high_str in ranges:
+        if low == high:
+            out.append(low_str)
+        else:
+            out.append("%s-%s" % (low_str, high_str))
+    return ",".join(out)
+
+def union_rl(ranges, type_max):
+    ranges = sorted(ranges)
+    merged = []
+    for r in ranges:
+        if merged:
+            last = merged[-1]
+            # overlapping or touching ranges are joined like add_range()
+            if r[0] <= last[2] or (last[2] != type_max and last[2] + 1 == r[0]):
+                if r[2] > last[2]:
+                    last[2] = r[2]
+                    last[3] = r[3]
+                continue
+        merged.append(list(r))
+    return merged
+
+def merge_local_values(shard_files, file_name, prefix):
+    values = {}
+    limits = {}
+    for f in shard_files:
+        for name, type_min, type_max, rl in f.local_values:
+            ranges = parse_rl(rl)
+            if ranges is None:
+                fatal("cannot parse the local_values range '%s' for '%s'" % (rl, name))
+            values.setdefault(name, []).extend(ranges)
+            limits[name] = (type_min, type_max)
+
+    out = []
+    for name in sorted(values, key=lambda x: x.encode("utf-8", "surrogateescape")):
+        type_min, type_max = limits[name]
+        merged = union_rl(values[name], parse_val(type_max))
+        if merged[0][0] == parse_val(type_min) and merged[0][2] == parse_val(type_max):
+            continue
+        out.append("%s (null)() SQL: insert into local_values values('%s', '%s', '%s');" %
+                   (prefix, file_name, name, show_rl(merged)))
+    return out
+
+def renumber(unit, offset):
+    if not offset:
+        return unit.lines
+    out = []
+    for line in unit.lines:
+        m = RETURN_ID.match(line)
+        if m:
+            line = "%s%d%s" % (m.group(1), int(m.group(2)) + offset, m.group(3))
+        out.append(line)
+    return out
+
+def merge_file(shard_files, out):
+    first = shard_files[0]
+    for f in shard_files:
+        if f.name != first.name or f.nr != first.nr:
+            fatal("the shards are for different files: %s and %s" % (first.name, f.name))
+        if not f.end_file:
+            fatal("%s: a shard did not finish" % f.name)
+
+    for line in first.prologue:
+        out.write(line + "\n")
+
+    owners = {}
+    for f in shard_files:
+        for u in f.units:
+            if u.kind == "function":
+                owners[u.idx] = u
+    for idx in range(first.nr):
+        if idx not in owners:
+            fatal("%s: function %d is not in any shard" % (first.name, idx))
+
+    # the inline functions at the end come from the first shard
+    units = [u for f in shard_files for u in f.units
+             if u.kind != "function" and (u.idx < first.nr or u.shard == 0)]
+    units.extend(owners.values())
+    units.sort(key=lambda u: (u.idx, u.kind != "function", u.shard, u.seq))
+
+    cursor = first.start
+    seen = set()
+    pos = first.loop_end
+    for u in units:
+        if u.kind != "function":
+            if u.key() in seen:
+                continue
+            seen.add(u.key())
+        for line in renumber(u, cursor - u.start):
+            out.write(line + "\n")
+        cursor += u.end - u.start
+        if u.idx == first.nr or (u.idx == first.nr - 1 and first.last_is_function):
+            pos = u.pos
+
+    old_prefix = "%s:%s " % first.end_file
+    new_prefix = "%s:%s " % pos
+    for line in first.epilogue:
+        if line is None:
+            for row in merge_local_values(shard_files, first.name, new_prefix.rstrip()):
+                out.write(row + "\n")
+            continue
+        if line.startswith(old_prefix):
+            line = new_prefix + line[len(old_prefix):]
+        out.write(line + "\n")
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage:  %s <shard output>..." % sys.argv[0])
+        sys.exit(1)
+
+    shards = [read_shard(name, i) for i, name in enumerate(sys.argv[1:])]
+    nr_files = len(shards[0][0])
+    for files, trailing in shards:
+        if len(files) != nr_files:
+            fatal("the shards checked a different number of files")
+
+    out = open(sys.stdout.fileno(), "w", encoding="utf-8",
+               errors="surrogateescape", closefd=False)
+    for i in range(nr_files):
+        merge_file([files[i] for files, trailing in shards], out)
+    for line in shards[0][1]:
+        out.write(line + "\n")
+    out.flush()
+
+main()
@@ -0,0 +1,194 @@
+#!/usr/bin/python3
+
+#
+# A small language server which shows the Smatch warnings in an editor.  It
+# starts "smatch --server" and when a buffer changes it only asks Smatch to
+# look at the function which was edited.  See smatch_server.c.
+#
+# Usage:  smatch_lsp.py [--smatch=<path>] [smatch and sparse arguments]
+#
+# For the kernel, give it the same -I and -D arguments as kchecker.  The
+# editor should run it from the top of the source tree.
+#
+
+import json
+import os
+import select
+import subprocess
+import sys
+import urllib.parse
+
+# wait this long after the last change before checking the buffer
+DELAY = 0.3
+
+SEVERITY = {"error": 1, "warn": 2, "info": 3}
+
+class Document:
+    def __init__(self, path, text):
+        self.path = path
+        self.lines = text.split("\n")
+        self.text = text
+        self.diagnostics = []
+        self.dirty_line = 0
+
+class Server:
+    def __init__(self, smatch, args):
+        self.smatch = subprocess.Popen([smatch, "--server"] + args,
+                                       stdin=subprocess.PIPE,
+                                       stdout=subprocess.PIPE)
+
+    def check(self, doc, line):
+        data = doc.text.encode("utf-8", "surrogateescape")
+        self.smatch.stdin.write(b"buffer %d %d %s\n" % (line, len(data),
+                                os.fsencode(doc.path)))
+        self.smatch.stdin.write(data)
+        self.smatch.stdin.flush()
+        answer = self.smatch.stdout.readline()
+        if not answer:
+            sys.stderr.write("smatch_lsp: smatch --server died\n")
+            sys.exit(1)
+        return json.loads(answer)
+
+class Lsp:
+    def __init__(self, server):
+        self.server = server
+        self.docs = {}
+        self.input = b""
+
+    def read_message(self, timeout):
+        while True:
+            end = self.input.find(b"\r\n\r\n")
+            if end >= 0:
+                length = 0
+                for header in self.input[:end].split(b"\r\n"):
+                    name, _, value = header.partition(b":")
+                    if name.strip().lower() == b"content-length":
+                        length = int(value)
+                if len(self.input) >= end + 4 + length:
+                    body = self.input[end + 4:end + 4 + length]
+                    self.input = self.input[end + 4 + length:]
+                    return json.loads(body)
+            ready, _, _ = select.select([0], [], [], timeout)
+            if not ready:
+                return None
+            data = os.read(0, 65536)
+            if not data:
+                sys.exit(0)
+            self.input += data
+
+    def send(self, msg):
+        msg["jsonrpc"] = "2.0"
+        body = json.dumps(msg).encode("utf-8")
+        sys.stdout.buffer.write(b"Content-Length: %d\r\n\r\n" % len(body))
+        sys.stdout.buffer.write(body)
+        sys.stdout.buffer.flush()
+
+    def publish(self, uri, doc):
+        diags = []
+        for d in doc.diagnostics:
+            line = max(d["line"] - 1, 0)
+            diags.append({
+                "range": {"start": {"line": line, "character": 0},
+                          "end": {"line": line, "character": 1000}},
+                "severity": SEVERITY.get(d["severity"], 3),
+                "source": "smatch",
+                "message": d["message"],
+            })
+        self.send({"method": "textDocument/publishDiagnostics",
+                   "params": {"uri": uri, "diagnostics": diags}})
+
+    def check(self, uri, doc, line):
+        answer = self.server.check(doc, line)
+        if answer.get("status") == "failed":
+            return
+        new = [d for d in answer.get("diagnostics", [])
+               if os.path.realpath(d["file"]) == os.path.realpath(doc.path)]
+        if line == 0:
+            doc.diagnostics = new
+        elif answer.get("status") == "ok":
+            start = answer["start"]
+            end = answer["end"] or sys.maxsize
+            doc.diagnostics = [d for d in doc.diagnostics
+                               if not start <= d["line"] <= end] + new
+        self.publish(uri, doc)
+
+    def change(self, doc, text):
+        lines = text.split("\n")
+        old = doc.lines
+        top = 0
+        while top < len(old) and top < len(lines) and old[top] == lines[top]:
+            top += 1
+        bottom = 0
+        while (bottom < len(old) - top and bottom < len(lines) - top and
+               old[-1 - bottom] == lines[-1 - bottom]):
+            bottom += 1
+
+        # move the old warnings after the change to their new lines
+        delta = len(lines) - len(old)
+        for d in doc.diagnostics:
+            if d["line"] > len(old) - bottom:
+                d["line"] += delta
+
+        doc.lines = lines
+        doc.text = text
+        if doc.dirty_line == 0 or top + 1 < doc.dirty_line:
+            doc.dirty_line = top + 1
+
+    def handle(self, msg):
+        method = msg.get("method")
+        params = msg.get("params", {})
+
+        if method == "initialize":
+            self.send({"id": msg["id"], "result": {"capabilities": {
+                "textDocumentSync": {"openClose": True, "change": 1}}}})
+        elif method == "shutdown":
+            self.send({"id": msg["id"], "result": None})
+        elif method == "exit":
+            sys.exit(0)
+        elif method == "textDocument/didOpen":
+            td = params["textDocument"]
+            path = urllib.parse.unquote(urllib.parse.urlparse(td["uri"]).path)
+            doc = Document(os.path.relpath(path), td["text"])
+            self.docs[td["uri"]] = doc
+            self.check(td["uri"], doc, 0)
+        elif method == "textDocument/didChange":
+            doc = self.docs.get(params["textDocument"]["uri"])
+            if doc:
+                self.change(doc, params["contentChanges"][-1]["text"])
+        elif method == "textDocument/didClose":
+            uri = params["textDocument"]["uri"]
+            if uri in self.docs:
+                del self.docs[uri]
+                self.send({"method": "textDocument/publishDiagnostics",
+                           "params": {"uri": uri, "diagnostics": []}})
+        elif "id" in msg:
+            self.send({"id": msg["id"], "error": {"code": -32601,
+                                                  "message": "not supported"}})
+
+    def run(self):
+        while True:
+            dirty = [uri for uri, doc in self.docs.items() if doc.dirty_line]
+            msg = self.read_message(DELAY if dirty else None)
+            if msg:
+                self.handle(msg)
+                continue
+            for uri in dirty:
+                doc = self.docs[uri]
+                line = doc.dirty_line
+                doc.dirty_line = 0
+                self.check(uri, doc, line)
+
+def main():
+    smatch = "smatch"
+    here = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "smatch")
+    if os.path.exists(here):
+        smatch = here
+    args = []
+    for arg in sys.argv[1:]:
+        if arg.startswith("--smatch="):
+            smatch = arg[9:]
+        else:
+            args.append(arg)
+    Lsp(Server(smatch, args)).run()
+
+main()
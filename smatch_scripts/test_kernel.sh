@@ -13,6 +13,7 @@ function usage {
     echo "	--target {TARGET} : specify build target, default: $TARGET"
     echo "	--log {FILE}      : Output compile log to file, default is: $LOG"
     echo "	--wlog {FILE}     : Output warnigs to file, default is: $WLOG"
+    echo "	--costs {FILE}    : Check the slowest files from an old $WLOG.cost first"
     echo "	--help            : Show this usage"
     exit 1
 }
@@ -21,6 +22,7 @@ function usage {
 while true ; do
     if [[ "$1" == "--endian" ]] ; then
 	ENDIAN="CF=-D__CHECK_ENDIAN__"
+	KCHECKER_ENDIAN="--endian"
 	shift
     elif [[ "$1" == "--target" ]] ; then
 	shift
@@ -34,6 +36,10 @@ while true ; do
 	shift
 	WLOG="$1"
 	shift
+    elif [[ "$1" == "--costs" ]] ; then
+	shift
+	COSTS="$1"
+	shift
     elif [[ "$1" == "--help" ]] ; then
 	usage
     else
@@ -54,9 +60,24 @@ fi
 
 make clean
 find -name \*.c.smatch -exec rm \{\} \;
-make -j${NR_CPU} $ENDIAN -k CHECK="$CMD -p=kernel --file-output $*" \
+if [ "$COSTS" != "" ] ; then
+    # build everything first and then check the files from the slowest down
+    cp $COSTS $COSTS.old
+    make -j${NR_CPU} -k $TARGET 2>&1 | tee $LOG
+    find -name \*.o | grep -v -e '\.mod\.o$' -e 'built-in\.o$' | \
+	sed -e 's/\.o$/.c/' | while read cfile ; do
+	    [ -e $cfile ] && echo ${cfile#./}
+	done | \
+	$SCRIPT_DIR/cost_schedule.py --jobs=${NR_CPU} --costs=$COSTS.old \
+	    --cmd="$SCRIPT_DIR/kchecker $KCHECKER_ENDIAN --file-output --cost-stats $* >> $LOG 2>&1"
+    rm $COSTS.old
+else
+    make -j${NR_CPU} $ENDIAN -k CHECK="$CMD -p=kernel --file-output --cost-stats $*" \
 	C=1 $TARGET 2>&1 | tee $LOG
+fi
 find -name \*.c.smatch -exec cat \{\} \; -exec rm \{\} \; > $WLOG
+grep "^cost: " $WLOG > $WLOG.cost
+sed -i -e '/^cost: /d' $WLOG
 find -name \*.c.smatch.sql -exec cat \{\} \; -exec rm \{\} \; > $WLOG.sql
 find -name \*.c.smatch.caller_info -exec cat \{\} \; -exec rm \{\} \; > $WLOG.caller_info
 
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * "smatch --server [sparse arguments]" is for editors.  It loads the hooks,
+ * the DB and the -include files once and then reads requests from stdin:
+ *
+ *	check <line> <file>
+ *	buffer <line> <bytes> <file>
+ *	quit
+ *
+ * "check" analyses the function in <file> which contains <line>.  "buffer"
+ * is the same but the source is the <bytes> bytes after the request line
+ * instead of what is on disk, so an editor can send a buffer which hasn't
+ * been saved.  If <line> is 0 the whole file is analysed.
+ *
+ * Each request is done in a forked child so nothing leaks from one request
+ * to the next.  The child still has to preprocess and parse the file but it
+ * only analyses the function which changed and the inline functions that
+ * it calls.  The answer is one line of JSON on stdout:
+ *
+ *	{"file": "a.c", "line": 10, "function": "foo", "start": 8, "end": 20,
+ *	 "status": "ok", "usecs": 52000, "diagnostics": [{"file": "a.c",
+ *	 "line": 12, "function": "foo", "severity": "warn", "message": "..."}]}
+ *
+ * "start" and "end" are the lines from the start of the function to the
+ * line before the next function, or 0 if it's the last function.  So the
+ * editor can throw away the old diagnostics between those lines and use the
+ * new ones.  The "status" is "ok", "no function" if <line> isn't in a
+ * function or "failed" if the child crashed.
+ *
+ * smatch_scripts/smatch_lsp.py is a language server which uses this.
+ */
+
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include "smatch.h"
+#include "token.h"
+
+int option_server;
+
+static int server_line;
+static struct symbol *server_function;
+
+static int has_body(struct symbol *sym)
+{
+	struct symbol *base;
+
+	if (sym->type != SYM_NODE)
+		return 0;
+	base = get_base_type(sym);
+	if (!base || base->type != SYM_FN)
+		return 0;
+	return base->stmt || sym->lazy_body;
+}
+
+void server_start_file(struct symbol_list *sym_list)
+{
+	struct symbol *sym;
+	int end = 0;
+
+	if (!option_server || !server_line)
+		return;
+
+	server_function = NULL;
+	FOR_EACH_PTR(sym_list, sym) {
+		if (!has_body(sym))
+			continue;
+		if (strcmp(stream_name(sym->pos.stream), get_base_file()) != 0)
+			continue;
+		/* the static functions aren't in order */
+		if (sym->pos.line > server_line) {
+			if (!end || sym->pos.line - 1 < end)
+				end = sym->pos.line - 1;
+			continue;
+		}
+		if (!server_function || sym->pos.line > server_function->pos.line)
+			server_function = sym;
+	} END_FOR_EACH_PTR(sym);
+
+	if (!server_function)
+		return;
+	fprintf(sm_outfd, "smatch_server: function|%s|%d|%d\n",
+		server_function->ident ? server_function->ident->name : "",
+		server_function->pos.line, end);
+}
+
+int server_wants_function(struct symbol *sym)
+{
+	return !server_line || sym == server_function;
+}
+
+int server_checks_whole_file(void)
+{
+	return !option_server || !server_line;
+}
+
+static void print_json_string(const char *str, int len)
+{
+	const unsigned char *p = (const unsigned char *)str;
+	int i;
+
+	putchar('"');
+	for (i = 0; i < len && p[i]; i++) {
+		if (p[i] == '"' || p[i] == '\\')
+			printf("\\%c", p[i]);
+		else if (p[i] == '\n')
+			printf("\\n");
+		else if (p[i] == '\t')
+			printf("\\t");
+		else if (p[i] < 0x20)
+			printf("\\u%04x", p[i]);
+		else
+			putchar(p[i]);
+	}
+	putchar('"');
+}
+
+struct diagnostic {
+	char *file, *func, *msg;
+	int file_len, func_len;
+	int line;
+	const char *severity;
+};
+
+/*
+ * The messages look like "file.c:123 func() warn: something".  Returns 0 if
+ * the line isn't one.
+ */
+static int parse_diagnostic(char *line, struct diagnostic *d)
+{
+	char *colon, *end;
+
+	for (colon = strchr(line, ':'); colon; colon = strchr(colon + 1, ':')) {
+		if (isdigit((unsigned char)colon[1]))
+			break;
+	}
+	if (!colon)
+		return 0;
+	d->line = strtol(colon + 1, &end, 10);
+	if (*end != ' ')
+		return 0;
+	d->func = end + 1;
+	d->msg = strstr(d->func, "() ");
+	if (!d->msg)
+		return 0;
+	d->file = line;
+	d->file_len = colon - line;
+	d->func_len = d->msg - d->func;
+	d->msg += 3;
+	d->severity = "info";
+	if (strncmp(d->msg, "warn: ", 6) == 0)
+		d->severity = "warn";
+	else if (strncmp(d->msg, "error: ", 7) == 0)
+		d->severity = "error";
+	return 1;
+}
+
+static void print_diagnostic(struct diagnostic *d, int first)
+{
+	printf("%s{\"file\": ", first ? "" : ", ");
+	print_json_string(d->file, d->file_len);
+	printf(", \"line\": %d, \"function\": ", d->line);
+	print_json_string(d->func, d->func_len);
+	printf(", \"severity\": \"%s\", \"message\": ", d->severity);
+	print_json_string(d->msg, strlen(d->msg));
+	printf("}");
+}
+
+static void print_answer(const char *file, int line, char *output,
+			 const char *status, long long usecs)
+{
+	char function[256] = "";
+	struct diagnostic d, cur;
+	int start = 0, end = 0;
+	char *p, *next;
+	int have = 0, in_msg = 0, first = 1;
+
+	p = strstr(output, "smatch_server: function|");
+	if (p)
+		sscanf(p + 24, "%255[^|]|%d|%d", function, &start, &end);
+	else if (line && strcmp(status, "ok") == 0)
+		status = "no function";
+
+	printf("{\"file\": ");
+	print_json_string(file, strlen(file));
+	printf(", \"line\": %d, \"function\": ", line);
+	print_json_string(function, strlen(function));
+	printf(", \"start\": %d, \"end\": %d, \"status\": \"%s\", \"usecs\": %lld, \"diagnostics\": [",
+	       start, end, status, usecs);
+	for (p = output; *p; p = next) {
+		next = strchr(p, '\n');
+		if (next)
+			*next++ = '\0';
+		else
+			next = p + strlen(p);
+		if (parse_diagnostic(p, &d)) {
+			if (have) {
+				print_diagnostic(&cur, first);
+				first = 0;
+			}
+			cur = d;
+			have = in_msg = 1;
+		} else if (in_msg && isspace((unsigned char)*p)) {
+			/* "  Locked on: line 13" and so on belong to the warning */
+			p[-1] = '\n';
+		} else {
+			in_msg = 0;
+		}
+	}
+	if (have)
+		print_diagnostic(&cur, first);
+	printf("]}\n");
+	fflush(stdout);
+}
+
+static int copy_buffer(FILE *out, int bytes)
+{
+	char buf[4096];
+	int len;
+
+	while (bytes > 0) {
+		len = fread(buf, 1, bytes < sizeof(buf) ? bytes : sizeof(buf), stdin);
+		if (len <= 0)
+			return -1;
+		fwrite(buf, 1, len, out);
+		bytes -= len;
+	}
+	return 0;
+}
+
+static char *read_output(int fd)
+{
+	char *buf = NULL;
+	size_t size = 0, len = 0;
+	ssize_t ret;
+
+	do {
+		if (len + 4096 + 1 > size) {
+			size = size ? size * 2 : 8192;
+			buf = realloc(buf, size);
+		}
+		ret = read(fd, buf + len, size - len - 1);
+		if (ret > 0)
+			len += ret;
+	} while (ret > 0);
+	buf[len] = '\0';
+	return buf;
+}
+
+static char empty[1];
+
+static void do_request(char *file, int line, FILE *source)
+{
+	struct timeval start, stop;
+	const char *status = "ok";
+	char *output;
+	int pipes[2];
+	int status_code;
+	pid_t pid;
+
+	gettimeofday(&start, NULL);
+	if (pipe(pipes) < 0) {
+		print_answer(file, line, empty, "failed", 0);
+		return;
+	}
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+		close(pipes[0]);
+		dup2(pipes[1], STDOUT_FILENO);
+		close(pipes[1]);
+		server_line = line;
+		smatch_check_file(file, source ? dup(fileno(source)) : -1);
+		fflush(stdout);
+		_exit(0);
+	}
+	close(pipes[1]);
+	output = read_output(pipes[0]);
+	close(pipes[0]);
+	if (pid < 0 || waitpid(pid, &status_code, 0) < 0 ||
+	    !WIFEXITED(status_code) || WEXITSTATUS(status_code) != 0)
+		status = "failed";
+	gettimeofday(&stop, NULL);
+
+	print_answer(file, line, output, status,
+		     (stop.tv_sec - start.tv_sec) * 1000000LL +
+		     (stop.tv_usec - start.tv_usec));
+	free(output);
+}
+
+void server_main(void)
+{
+	char buf[PATH_MAX + 64];
+	char file[sizeof(buf)];
+	FILE *source;
+	int line, bytes;
+	int c;
+
+	/* the answers have to be the only thing on stdout */
+	if (option_info || option_file_output || option_info_frames ||
+	    function_shard_mode()) {
+		printf("FATAL ERROR: --server can't be used with --info, --info-frames, --file-output or the function shards\n");
+		exit(1);
+	}
+
+	while (fgets(buf, sizeof(buf), stdin)) {
+		if (!strchr(buf, '\n')) {
+			/* too long, throw away the rest of the line */
+			while ((c = getchar()) != EOF && c != '\n')
+				;
+			printf("{\"status\": \"bad request\"}\n");
+			fflush(stdout);
+			continue;
+		}
+		buf[strcspn(buf, "\n")] = '\0';
+		if (strcmp(buf, "quit") == 0)
+			break;
+		if (sscanf(buf, "check %d %[^\n]", &line, file) == 2) {
+			do_request(file, line, NULL);
+			continue;
+		}
+		if (sscanf(buf, "buffer %d %d %[^\n]", &line, &bytes, file) == 3) {
+			source = tmpfile();
+			if (!source || copy_buffer(source, bytes) < 0) {
+				if (source)
+					fclose(source);
+				print_answer(file, line, empty, "failed", 0);
+				continue;
+			}
+			fflush(source);
+			rewind(source);
+			do_request(file, line, source);
+			fclose(source);
+			continue;
+		}
+		printf("{\"status\": \"bad request\"}\n");
+		fflush(stdout);
+	}
+}
@@ -22,10 +22,25 @@
 
 #undef CHECKORDER
 
-ALLOCATOR(smatch_state, "smatch state");
-ALLOCATOR(sm_state, "sm state");
+/*
+ * Everything in the function arena is thrown away at the end of each
+ * function.  The permanent arena is for the global states which have to
+ * outlive the function.
+ */
+struct allocator_arena function_arena = { .name = "function" };
+struct allocator_arena perm_arena = { .name = "permanent" };
+
+ARENA_ALLOCATOR(smatch_state, "smatch state", &function_arena);
+ARENA_ALLOCATOR(sm_state, "sm state", &function_arena);
 ALLOCATOR(named_stree, "named slist");
-__DO_ALLOCATOR(char, 1, 4, "state names", sname);
+__DO_ARENA_ALLOCATOR(char, 1, 4, "state names", sname, &function_arena);
+__DO_ARENA_ALLOCATOR(char, 1, 4, "permanent state names", perm_sname, &perm_arena);
+__DO_ARENA_ALLOCATOR(struct sm_state, sizeof(struct sm_state), __alignof__(struct sm_state),
+		     "permanent sm state", perm_sm_state, &perm_arena);
+__DO_ARENA_ALLOCATOR(struct smatch_state, sizeof(struct smatch_state), __alignof__(struct smatch_state),
+		     "permanent smatch state", perm_smatch_state, &perm_arena);
+
+int option_max_possible = 100;
 
 static int sm_state_counter;
 
@@ -169,6 +184,7 @@ struct sm_state *alloc_sm_state(int owner, const char *name,
 	sm_state->nr_children = 1;
 	sm_state->possible = NULL;
 	add_ptr_list(&sm_state->possible, sm_state);
+	sm_state->nr_possible = 1;
 	return sm_state;
 }
 
@@ -185,7 +201,7 @@ static struct sm_state *alloc_state_no_name(int owner, const char *name,
 
 int too_many_possible(struct sm_state *sm)
 {
-	if (ptr_list_size((struct ptr_list *)sm->possible) >= 100)
+	if (sm->nr_possible >= option_max_possible)
 		return 1;
 	return 0;
 }
@@ -194,30 +210,94 @@ void add_possible_sm(struct sm_state *to, struct sm_state *new)
 {
 	struct sm_state *tmp;
 	int preserve = 1;
+	int ret;
 
 	if (too_many_possible(to))
 		preserve = 0;
 
 	FOR_EACH_PTR(to->possible, tmp) {
-		if (cmp_sm_states(tmp, new, preserve) < 0)
+		ret = cmp_sm_states(tmp, new, preserve);
+		if (ret < 0)
 			continue;
-		else if (cmp_sm_states(tmp, new, preserve) == 0) {
+		if (ret == 0)
 			return;
-		} else {
-			INSERT_CURRENT(new, tmp);
-			return;
-		}
+		INSERT_CURRENT(new, tmp);
+		to->nr_possible++;
+		return;
 	} END_FOR_EACH_PTR(tmp);
 	add_ptr_list(&to->possible, new);
+	to->nr_possible++;
 }
 
+/*
+ * Both ->possible lists are sorted so instead of calling add_possible_sm()
+ * for every state, which starts from the beginning of the list each time,
+ * we walk the two lists together and build a new list.  This has to give
+ * exactly the same result as add_possible_sm().  Because of the SMATCH_EXTRA
+ * hack in cmp_sm_states() a state can be inserted in front of the state
+ * that we inserted just before it so the new states are held on a stack
+ * until we've moved past them.  Once the list is too big cmp_sm_states()
+ * changes the sort order so at that point we go back to add_possible_sm().
+ */
 static void copy_possibles(struct sm_state *to, struct sm_state *from)
 {
-	struct sm_state *tmp;
+	struct state_list *list = NULL;
+	struct state_list *pending = NULL;
+	struct sm_state *cur, *new, *tmp;
+	int done = 0;
+	int ret = 0;
+
+	PREPARE_PTR_LIST(to->possible, cur);
+	FOR_EACH_PTR(from->possible, new) {
+		if (!done && too_many_possible(to)) {
+			while ((tmp = delete_ptr_list_last((struct ptr_list **)&pending)))
+				add_ptr_list(&list, tmp);
+			while (cur) {
+				add_ptr_list(&list, cur);
+				NEXT_PTR_LIST(cur);
+			}
+			free_slist(&to->possible);
+			to->possible = list;
+			done = 1;
+		}
+		if (done) {
+			add_possible_sm(to, new);
+			continue;
+		}
 
-	FOR_EACH_PTR(from->possible, tmp) {
-		add_possible_sm(to, tmp);
-	} END_FOR_EACH_PTR(tmp);
+		for (;;) {
+			tmp = pending ? last_ptr_list((struct ptr_list *)pending) : cur;
+			if (!tmp)
+				break;
+			ret = cmp_sm_states(tmp, new, 1);
+			if (ret >= 0)
+				break;
+			add_ptr_list(&list, tmp);
+			if (pending)
+				delete_ptr_list_last((struct ptr_list **)&pending);
+			else
+				NEXT_PTR_LIST(cur);
+		}
+		if (tmp && ret == 0)
+			continue;
+		add_ptr_list(&pending, new);
+		to->nr_possible++;
+	} END_FOR_EACH_PTR(new);
+
+	if (!done) {
+		while ((tmp = delete_ptr_list_last((struct ptr_list **)&pending)))
+			add_ptr_list(&list, tmp);
+		while (cur) {
+			add_ptr_list(&list, cur);
+			NEXT_PTR_LIST(cur);
+		}
+	}
+	FINISH_PTR_LIST(cur);
+
+	if (!done) {
+		free_slist(&to->possible);
+		to->possible = list;
+	}
 }
 
 char *alloc_sname(const char *str)
@@ -231,6 +311,27 @@ char *alloc_sname(const char *str)
 	return tmp;
 }
 
+char *alloc_perm_sname(const char *str)
+{
+	char *tmp;
+
+	if (!str)
+		return NULL;
+	tmp = __alloc_perm_sname(strlen(str) + 1);
+	strcpy(tmp, str);
+	return tmp;
+}
+
+struct smatch_state *alloc_perm_smatch_state(void)
+{
+	return __alloc_perm_smatch_state(0);
+}
+
+void free_function_arena(void)
+{
+	reset_arena(&function_arena);
+}
+
 int out_of_memory(void)
 {
 	/*
@@ -243,6 +344,11 @@ int out_of_memory(void)
 	return 0;
 }
 
+int get_sm_state_count(void)
+{
+	return sm_state_counter;
+}
+
 int low_on_memory(void)
 {
 	if (sm_state_counter * sizeof(struct sm_state) >= 25000000)
@@ -272,25 +378,16 @@ static void free_all_sm_states(struct allocation_blob *blob)
 	}
 }
 
-/* At the end of every function we free all the sm_states */
+/*
+ * At the end of every function we free all the sm_states.  The memory
+ * itself is recycled by free_function_arena().
+ */
 void free_every_single_sm_state(void)
 {
-	struct allocator_struct *desc = &sm_state_allocator;
-	struct allocation_blob *blob = desc->blobs;
+	struct allocation_blob *blob;
 
-	desc->blobs = NULL;
-	desc->allocations = 0;
-	desc->total_bytes = 0;
-	desc->useful_bytes = 0;
-	desc->freelist = NULL;
-	while (blob) {
-		struct allocation_blob *next = blob->next;
+	for (blob = sm_state_allocator.blobs; blob; blob = blob->next)
 		free_all_sm_states(blob);
-		blob_free(blob, desc->chunking);
-		blob = next;
-	}
-	clear_sname_alloc();
-	clear_smatch_state_alloc();
 
 	free_stack_and_strees(&all_pools);
 	sm_state_counter = 0;
@@ -306,6 +403,7 @@ struct sm_state *clone_sm(struct sm_state *s)
 	/* clone_sm() doesn't copy the pools.  Each state needs to have
 	   only one pool. */
 	ret->possible = clone_slist(s->possible);
+	ret->nr_possible = s->nr_possible;
 	ret->left = s->left;
 	ret->right = s->right;
 	ret->nr_children = s->nr_children;
@@ -489,11 +587,9 @@ void set_state_stree_perm(struct stree **stree, int owner, const char *name,
 {
 	struct sm_state *sm;
 
-	sm = malloc(sizeof(*sm) + strlen(name) + 1);
-	memset(sm, 0, sizeof(*sm));
+	sm = __alloc_perm_sm_state(0);
 	sm->owner = owner;
-	sm->name = (char *)(sm + 1);
-	strcpy((char *)sm->name, name);
+	sm->name = alloc_perm_sname(name);
 	sm->sym = sym;
 	sm->state = state;
 
@@ -13,17 +13,24 @@ DECLARE_PTR_LIST(named_stree_stack, struct named_stree);
 
 
 extern struct state_list_stack *implied_pools;
+extern int option_max_possible;
 extern int __stree_id;
 
 char *show_sm(struct sm_state *sm);
 void __print_stree(struct stree *stree);
 void add_history(struct sm_state *sm);
 int cmp_tracker(const struct sm_state *a, const struct sm_state *b);
+extern struct allocator_arena function_arena;
+extern struct allocator_arena perm_arena;
+
 char *alloc_sname(const char *str);
+char *alloc_perm_sname(const char *str);
+struct smatch_state *alloc_perm_smatch_state(void);
 struct sm_state *alloc_sm_state(int owner, const char *name,
 				struct symbol *sym, struct smatch_state *state);
 
 void free_every_single_sm_state(void);
+void free_function_arena(void);
 struct sm_state *clone_sm(struct sm_state *s);
 int is_merged(struct sm_state *sm);
 int is_leaf(struct sm_state *sm);
@@ -71,6 +78,7 @@ struct smatch_state *get_state_stree_stack(struct stree_stack *stack, int owner,
 
 int out_of_memory(void);
 int low_on_memory(void);
+int get_sm_state_count(void);
 void merge_stree(struct stree **to, struct stree *stree);
 void merge_stree_no_pools(struct stree **to, struct stree *stree);
 void merge_stree(struct stree **to, struct stree *right);
@@ -30,7 +30,8 @@
 #include "smatch_slist.h"
 #include "smatch_extra.h"
 
-__ALLOCATOR(sval_t, "svals", sval);
+__ARENA_ALLOCATOR(sval_t, "svals", sval, &function_arena);
+__ARENA_ALLOCATOR(sval_t, "permanent svals", perm_sval, &perm_arena);
 
 sval_t *sval_alloc(sval_t sval)
 {
@@ -45,7 +46,7 @@ sval_t *sval_alloc_permanent(sval_t sval)
 {
 	sval_t *ret;
 
-	ret = malloc(sizeof(*ret));
+	ret = __alloc_perm_sval(0);
 	*ret = sval;
 	return ret;
 }
@@ -583,14 +584,6 @@ sval_t ll_to_sval(long long val)
 	return ret;
 }
 
-static void free_svals(struct symbol *sym)
-{
-	if (__inline_fn)
-		return;
-	clear_sval_alloc();
-}
-
 void register_sval(int my_id)
 {
-	add_hook(&free_svals, AFTER_FUNC_HOOK);
 }
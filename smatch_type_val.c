@@ -35,6 +35,7 @@
 #include "smatch.h"
 #include "smatch_slist.h"
 #include "smatch_extra.h"
+#include "smatch_function_hashtable.h"
 
 static int my_id;
 
@@ -42,14 +43,6 @@ struct stree_stack *fn_type_val_stack;
 struct stree *fn_type_val;
 struct stree *global_type_val;
 
-static int get_vals(void *_db_vals, int argc, char **argv, char **azColName)
-{
-	char **db_vals = _db_vals;
-
-	*db_vals = alloc_string(argv[0]);
-	return 0;
-}
-
 static void match_inline_start(struct expression *expr)
 {
 	push_stree(&fn_type_val_stack, fn_type_val);
@@ -62,28 +55,89 @@ static void match_inline_end(struct expression *expr)
 	fn_type_val = pop_stree(&fn_type_val_stack);
 }
 
+/*
+ * The type_value table is small and get_db_type_rl() is called for every
+ * struct member we look at so the whole table is read in the first time
+ * it's needed.  The range list for each member is parsed once and kept
+ * until someone asks for it with a different type.
+ */
+struct type_val_entry {
+	char *value;
+	struct symbol *type;
+	struct range_list *rl;
+};
+
+static DEFINE_HASHTABLE_INSERT(insert_type_val, char, struct type_val_entry);
+static DEFINE_HASHTABLE_SEARCH(search_type_val, char, struct type_val_entry);
+static struct hashtable *type_val_cache;
+static int type_val_rows;
+static unsigned long type_val_bytes;
+
+static int load_type_val_callback(void *unused, int argc, char **argv, char **azColName)
+{
+	struct type_val_entry *entry;
+
+	entry = search_type_val(type_val_cache, argv[0]);
+	if (entry) {
+		/* if there are duplicates the last row wins */
+		type_val_bytes += strlen(argv[1]) - strlen(entry->value);
+		free_string(entry->value);
+		entry->value = alloc_string(argv[1]);
+		return 0;
+	}
+
+	entry = malloc(sizeof(*entry));
+	entry->value = alloc_string(argv[1]);
+	entry->type = NULL;
+	entry->rl = NULL;
+	insert_type_val(type_val_cache, alloc_string(argv[0]), entry);
+	type_val_rows++;
+	type_val_bytes += sizeof(*entry) + strlen(argv[0]) + strlen(argv[1]) + 2;
+	return 0;
+}
+
+static void load_type_val_cache(void)
+{
+	struct timeval start;
+
+	if (type_val_cache)
+		return;
+
+	gettimeofday(&start, NULL);
+	type_val_cache = create_function_hashtable(4000);
+	function_cache_sticky(1);
+	run_sql(load_type_val_callback, NULL, "select type, value from type_value;");
+	function_cache_sticky(0);
+	mem_stats_db_cache("type_value", type_val_rows, type_val_bytes, &start);
+}
+
 int get_db_type_rl(struct expression *expr, struct range_list **rl)
 {
-	char *db_vals = NULL;
-	char *member;
-	struct range_list *tmp;
+	struct type_val_entry *entry;
 	struct symbol *type;
+	char *member;
 
 	member = get_member_name(expr);
 	if (!member)
 		return 0;
 
-	run_sql(get_vals, &db_vals,
-		"select value from type_value where type = '%s';", member);
+	load_type_val_cache();
+	entry = search_type_val(type_val_cache, member);
 	free_string(member);
-	if (!db_vals)
+	if (!entry)
 		return 0;
+
 	type = get_type(expr);
-	str_to_rl(type, db_vals, &tmp);
-	free_string(db_vals);
-	if (is_whole_rl(tmp))
+	if (!entry->rl || entry->type != type) {
+		struct range_list *tmp;
+
+		str_to_rl(type, entry->value, &tmp);
+		entry->rl = clone_rl_permanent(tmp);
+		entry->type = type;
+	}
+	if (is_whole_rl(entry->rl))
 		return 0;
-	*rl = tmp;
+	*rl = clone_rl(entry->rl);
 
 	return 1;
 }
@@ -92,7 +146,6 @@ static void add_type_val(char *member, struct range_list *rl)
 {
 	struct smatch_state *old, *add, *new;
 
-	member = alloc_string(member);
 	old = get_state_stree(fn_type_val, my_id, member, NULL);
 	add = alloc_estate_rl(rl);
 	if (old)
@@ -106,7 +159,6 @@ static void add_fake_type_val(char *member, struct range_list *rl, int ignore)
 {
 	struct smatch_state *old, *add, *new;
 
-	member = alloc_string(member);
 	old = get_state_stree(fn_type_val, my_id, member, NULL);
 	if (old && strcmp(old->name, "min-max") == 0)
 		return;
@@ -118,9 +170,9 @@ static void add_fake_type_val(char *member, struct range_list *rl, int ignore)
 	} else {
 		new = add;
 		if (ignore)
-			new->name = alloc_string("ignore");
+			new->name = alloc_sname("ignore");
 		else
-			new->name = alloc_string("min-max");
+			new->name = alloc_sname("min-max");
 	}
 	set_state_stree(&fn_type_val, my_id, member, NULL, new);
 }
@@ -129,7 +181,6 @@ static void add_global_type_val(char *member, struct range_list *rl)
 {
 	struct smatch_state *old, *add, *new;
 
-	member = alloc_string(member);
 	old = get_state_stree(global_type_val, my_id, member, NULL);
 	add = alloc_estate_rl(rl);
 	if (old)
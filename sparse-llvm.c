@@ -1,6 +1,7 @@
 /*
  * Example usage:
  *	./sparse-llvm hello.c | llc | as -o hello.o
+ *	./sparse-llvm -j 4 -o out a.c b.c c.c
  */
 
 #include <llvm-c/Core.h>
@@ -10,9 +11,15 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 #include "symbol.h"
 #include "expression.h"
@@ -20,6 +27,7 @@
 #include "flow.h"
 
 struct function {
+	LLVMContextRef			context;
 	LLVMBuilderRef			builder;
 	LLVMTypeRef			type;
 	LLVMValueRef			fn;
@@ -103,7 +111,7 @@ static LLVMTypeRef sym_struct_type(LLVMModuleRef module, struct symbol *sym)
 	unsigned nr = 0;
 
 	snprintf(buffer, sizeof(buffer), "struct.%s", sym->ident ? sym->ident->name : "anno");
-	ret = LLVMStructCreateNamed(LLVMGetGlobalContext(), buffer);
+	ret = LLVMStructCreateNamed(LLVMGetModuleContext(module), buffer);
 	/* set ->aux to avoid recursion */
 	sym->aux = ret;
 
@@ -123,6 +131,7 @@ static LLVMTypeRef sym_struct_type(LLVMModuleRef module, struct symbol *sym)
 
 static LLVMTypeRef sym_union_type(LLVMModuleRef module, struct symbol *sym)
 {
+	LLVMContextRef context = LLVMGetModuleContext(module);
 	LLVMTypeRef elements;
 	unsigned union_size;
 
@@ -133,9 +142,9 @@ static LLVMTypeRef sym_union_type(LLVMModuleRef module, struct symbol *sym)
 	 */
 	union_size = sym->bit_size / 8;
 
-	elements = LLVMArrayType(LLVMInt8Type(), union_size);
+	elements = LLVMArrayType(LLVMInt8TypeInContext(context), union_size);
 
-	return LLVMStructType(&elements, 1, 0 /* packed? */);
+	return LLVMStructTypeInContext(context, &elements, 1, 0 /* packed? */);
 }
 
 static LLVMTypeRef sym_ptr_type(LLVMModuleRef module, struct symbol *sym)
@@ -144,27 +153,28 @@ static LLVMTypeRef sym_ptr_type(LLVMModuleRef module, struct symbol *sym)
 
 	/* 'void *' is treated like 'char *' */
 	if (is_void_type(sym->ctype.base_type))
-		type = LLVMInt8Type();
+		type = LLVMInt8TypeInContext(LLVMGetModuleContext(module));
 	else
 		type = symbol_type(module, sym->ctype.base_type);
 
 	return LLVMPointerType(type, 0);
 }
 
-static LLVMTypeRef sym_basetype_type(struct symbol *sym)
+static LLVMTypeRef sym_basetype_type(LLVMModuleRef module, struct symbol *sym)
 {
+	LLVMContextRef context = LLVMGetModuleContext(module);
 	LLVMTypeRef ret = NULL;
 
 	if (symbol_is_fp_type(sym)) {
 		switch (sym->bit_size) {
 		case 32:
-			ret = LLVMFloatType();
+			ret = LLVMFloatTypeInContext(context);
 			break;
 		case 64:
-			ret = LLVMDoubleType();
+			ret = LLVMDoubleTypeInContext(context);
 			break;
 		case 80:
-			ret = LLVMX86FP80Type();
+			ret = LLVMX86FP80TypeInContext(context);
 			break;
 		default:
 			die("invalid bit size %d for type %d", sym->bit_size, sym->type);
@@ -173,22 +183,22 @@ static LLVMTypeRef sym_basetype_type(struct symbol *sym)
 	} else {
 		switch (sym->bit_size) {
 		case -1:
-			ret = LLVMVoidType();
+			ret = LLVMVoidTypeInContext(context);
 			break;
 		case 1:
-			ret = LLVMInt1Type();
+			ret = LLVMInt1TypeInContext(context);
 			break;
 		case 8:
-			ret = LLVMInt8Type();
+			ret = LLVMInt8TypeInContext(context);
 			break;
 		case 16:
-			ret = LLVMInt16Type();
+			ret = LLVMInt16TypeInContext(context);
 			break;
 		case 32:
-			ret = LLVMInt32Type();
+			ret = LLVMInt32TypeInContext(context);
 			break;
 		case 64:
-			ret = LLVMInt64Type();
+			ret = LLVMInt64TypeInContext(context);
 			break;
 		default:
 			die("invalid bit size %d for type %d", sym->bit_size, sym->type);
@@ -216,7 +226,7 @@ static LLVMTypeRef symbol_type(LLVMModuleRef module, struct symbol *sym)
 		ret = symbol_type(module, sym->ctype.base_type);
 		break;
 	case SYM_BASETYPE:
-		ret = sym_basetype_type(sym);
+		ret = sym_basetype_type(module, sym);
 		break;
 	case SYM_PTR:
 		ret = sym_ptr_type(module, sym);
@@ -244,14 +254,16 @@ static LLVMTypeRef symbol_type(LLVMModuleRef module, struct symbol *sym)
 
 static LLVMTypeRef insn_symbol_type(LLVMModuleRef module, struct instruction *insn)
 {
+	LLVMContextRef context = LLVMGetModuleContext(module);
+
 	if (insn->type)
 		return symbol_type(module, insn->type);
 
 	switch (insn->size) {
-		case 8:		return LLVMInt8Type();
-		case 16:	return LLVMInt16Type();
-		case 32:	return LLVMInt32Type();
-		case 64:	return LLVMInt64Type();
+		case 8:		return LLVMInt8TypeInContext(context);
+		case 16:	return LLVMInt16TypeInContext(context);
+		case 32:	return LLVMInt32TypeInContext(context);
+		case 64:	return LLVMInt64TypeInContext(context);
 
 		default:
 			die("invalid bit size %d", insn->size);
@@ -322,13 +334,14 @@ static LLVMValueRef pseudo_to_value(struct function *fn, struct instruction *ins
 			switch (expr->type) {
 			case EXPR_STRING: {
 				const char *s = expr->string->data;
-				LLVMValueRef indices[] = { LLVMConstInt(LLVMInt64Type(), 0, 0), LLVMConstInt(LLVMInt64Type(), 0, 0) };
+				LLVMTypeRef i64 = LLVMInt64TypeInContext(fn->context);
+				LLVMValueRef indices[] = { LLVMConstInt(i64, 0, 0), LLVMConstInt(i64, 0, 0) };
 				LLVMValueRef data;
 
-				data = LLVMAddGlobal(fn->module, LLVMArrayType(LLVMInt8Type(), strlen(s) + 1), ".str");
+				data = LLVMAddGlobal(fn->module, LLVMArrayType(LLVMInt8TypeInContext(fn->context), strlen(s) + 1), ".str");
 				LLVMSetLinkage(data, LLVMPrivateLinkage);
 				LLVMSetGlobalConstant(data, 1);
-				LLVMSetInitializer(data, LLVMConstString(strdup(s), strlen(s) + 1, true));
+				LLVMSetInitializer(data, LLVMConstStringInContext(fn->context, strdup(s), strlen(s) + 1, true));
 
 				result = LLVMConstGEP(data, indices, ARRAY_SIZE(indices));
 				break;
@@ -383,7 +396,7 @@ static LLVMValueRef calc_gep(LLVMBuilderRef builder, LLVMValueRef base, LLVMValu
 {
 	LLVMTypeRef type = LLVMTypeOf(base);
 	unsigned int as = LLVMGetPointerAddressSpace(type);
-	LLVMTypeRef bytep = LLVMPointerType(LLVMInt8Type(), as);
+	LLVMTypeRef bytep = LLVMPointerType(LLVMInt8TypeInContext(LLVMGetTypeContext(type)), as);
 	LLVMValueRef addr;
 
 	/* convert base to char* type */
@@ -580,7 +593,7 @@ static LLVMValueRef calc_memop_addr(struct function *fn, struct instruction *ins
 	unsigned int as;
 
 	/* int type large enough to hold a pointer */
-	int_type = LLVMIntType(bits_in_pointer);
+	int_type = LLVMIntTypeInContext(fn->context, bits_in_pointer);
 	off = LLVMConstInt(int_type, insn->offset, 0);
 
 	/* convert src to the effective pointer type */
@@ -623,7 +636,7 @@ static void output_op_store(struct function *fn, struct instruction *insn)
 
 static LLVMValueRef bool_value(struct function *fn, LLVMValueRef value)
 {
-	if (LLVMTypeOf(value) != LLVMInt1Type())
+	if (LLVMTypeOf(value) != LLVMInt1TypeInContext(fn->context))
 		value = LLVMBuildIsNotNull(fn->builder, value, "cond");
 
 	return value;
@@ -680,7 +693,7 @@ static void output_op_switch(struct function *fn, struct instruction *insn)
 	FOR_EACH_PTR(insn->multijmp_list, jmp) {
 		if (jmp->begin == jmp->end) {		/* case N */
 			LLVMAddCase(target,
-				LLVMConstInt(LLVMInt32Type(), jmp->begin, 0),
+				LLVMConstInt(LLVMInt32TypeInContext(fn->context), jmp->begin, 0),
 				jmp->target->priv);
 		} else if (jmp->begin < jmp->end) {	/* case M..N */
 			assert(0);
@@ -946,7 +959,10 @@ static void output_fn(LLVMModuleRef module, struct entrypoint *ep)
 	struct symbol *ret_type = sym->ctype.base_type->ctype.base_type;
 	LLVMTypeRef arg_types[MAX_ARGS];
 	LLVMTypeRef return_type;
-	struct function function = { .module = module };
+	struct function function = {
+		.context = LLVMGetModuleContext(module),
+		.module = module,
+	};
 	struct basic_block *bb;
 	struct symbol *arg;
 	const char *name;
@@ -969,7 +985,7 @@ static void output_fn(LLVMModuleRef module, struct entrypoint *ep)
 
 	LLVMSetLinkage(function.fn, function_linkage(sym));
 
-	function.builder = LLVMCreateBuilder();
+	function.builder = LLVMCreateBuilderInContext(function.context);
 
 	static int nr_bb;
 
@@ -982,7 +998,7 @@ static void output_fn(LLVMModuleRef module, struct entrypoint *ep)
 		struct instruction *insn;
 
 		sprintf(bbname, "L%d", nr_bb++);
-		bbr = LLVMAppendBasicBlock(function.fn, bbname);
+		bbr = LLVMAppendBasicBlockInContext(function.context, function.fn, bbname);
 
 		bb->priv = bbr;
 
@@ -1040,7 +1056,7 @@ static LLVMValueRef output_data(LLVMModuleRef module, struct symbol *sym)
 		case EXPR_STRING: {
 			const char *s = initializer->string->data;
 
-			initial_value = LLVMConstString(strdup(s), strlen(s) + 1, true);
+			initial_value = LLVMConstStringInContext(LLVMGetModuleContext(module), strdup(s), strlen(s) + 1, true);
 			break;
 		}
 		default:
@@ -1136,15 +1152,223 @@ static void set_target(LLVMModuleRef module)
 	LLVMSetDataLayout(module, layout);
 }
 
+/*
+ * With "-o <dir>" every input file becomes its own module, written to
+ * <dir>/<file>.bc (or .ll with -S) where the '/'s in the file name are
+ * written as "%2F" and the '%'s as "%25", so two files can't end up with
+ * the same name.  Sparse keeps its state in globals, so each file is
+ * done in a forked worker with its own LLVMContext, and up to <jobs> of
+ * them run at once.  Each worker's diagnostics go to a log file which is
+ * copied to stderr in command line order once everything is done, so the
+ * output doesn't depend on which worker finished first.
+ */
+struct job {
+	pid_t pid;
+	int status;
+	char *file;
+	char out[PATH_MAX];
+	char log[PATH_MAX];
+};
+
+static void emit_one_file(struct symbol_list *builtins, struct job *job, bool text)
+{
+	struct symbol_list *symlist;
+	LLVMContextRef context;
+	LLVMModuleRef module;
+	char *error = NULL;
+	int fd;
+
+	fd = open(job->log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd >= 0) {
+		dup2(fd, STDERR_FILENO);
+		close(fd);
+	}
+
+	context = LLVMContextCreate();
+	module = LLVMModuleCreateWithNameInContext(job->file, context);
+	set_target(module);
+
+	compile(module, builtins);
+
+	/* need ->phi_users */
+	dbg_dead = 1;
+	symlist = sparse(job->file);
+	if (die_if_error)
+		_exit(1);
+	compile(module, symlist);
+
+	LLVMVerifyModule(module, LLVMPrintMessageAction, NULL);
+
+	if (text) {
+		if (LLVMPrintModuleToFile(module, job->out, &error)) {
+			fprintf(stderr, "%s: %s\n", job->out, error);
+			_exit(1);
+		}
+	} else if (LLVMWriteBitcodeToFile(module, job->out)) {
+		fprintf(stderr, "%s: %s\n", job->out, strerror(errno));
+		_exit(1);
+	}
+
+	LLVMDisposeModule(module);
+	LLVMContextDispose(context);
+	fflush(stdout);
+	fflush(stderr);
+	_exit(0);
+}
+
+static void wait_for_job(struct job *jobs, int nr, int *running)
+{
+	int status, i;
+	pid_t pid;
+
+	pid = wait(&status);
+	if (pid < 0)
+		die("wait: %s", strerror(errno));
+
+	for (i = 0; i < nr; i++) {
+		if (jobs[i].pid == pid)
+			break;
+	}
+	if (i == nr)
+		return;
+
+	jobs[i].status = status;
+	jobs[i].pid = 0;
+	(*running)--;
+}
+
+static void show_log(const char *log)
+{
+	char buf[4096];
+	size_t n;
+	FILE *f;
+
+	f = fopen(log, "r");
+	if (!f)
+		return;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		fwrite(buf, 1, n, stderr);
+	fclose(f);
+}
+
+static void escape_name(char *buf, size_t size, const char *file)
+{
+	const char *p = file;
+	size_t len = 0;
+
+	while (p[0] == '.' && p[1] == '/')
+		p += 2;
+	for (; *p; p++) {
+		if (len + 4 > size)
+			die("file name too long: %s", file);
+		if (*p == '/' || *p == '%')
+			len += sprintf(buf + len, "%%%02X", *p);
+		else
+			buf[len++] = *p;
+	}
+	buf[len] = '\0';
+}
+
+static void make_path(char *buf, size_t size, const char *dir,
+		      const char *name, const char *ext)
+{
+	int len = snprintf(buf, size, "%s/%s.%s", dir, name, ext);
+
+	if (len < 0 || len >= size)
+		die("path too long: %s/%s.%s", dir, name, ext);
+}
+
+static int emit_files(struct symbol_list *builtins, struct string_list *filelist,
+		      const char *dir, int nr_jobs, bool text)
+{
+	struct job *jobs;
+	int nr = 0, running = 0, failed = 0;
+	char name[PATH_MAX];
+	char *file;
+	int i;
+
+	jobs = calloc(ptr_list_size((struct ptr_list *)filelist), sizeof(*jobs));
+	if (!jobs)
+		die("out of memory");
+
+	fflush(stdout);
+	fflush(stderr);
+	FOR_EACH_PTR_NOTAG(filelist, file) {
+		struct job *job = &jobs[nr++];
+
+		escape_name(name, sizeof(name), file);
+		job->file = file;
+		make_path(job->out, sizeof(job->out), dir, name, text ? "ll" : "bc");
+		make_path(job->log, sizeof(job->log), dir, name, "log");
+
+		while (running == nr_jobs)
+			wait_for_job(jobs, nr, &running);
+
+		job->pid = fork();
+		if (job->pid < 0)
+			die("fork: %s", strerror(errno));
+		if (job->pid == 0)
+			emit_one_file(builtins, job, text);
+		running++;
+	} END_FOR_EACH_PTR_NOTAG(file);
+
+	while (running)
+		wait_for_job(jobs, nr, &running);
+
+	for (i = 0; i < nr; i++) {
+		show_log(jobs[i].log);
+		unlink(jobs[i].log);
+		if (WIFEXITED(jobs[i].status) && WEXITSTATUS(jobs[i].status) == 0)
+			continue;
+		if (WIFSIGNALED(jobs[i].status))
+			fprintf(stderr, "sparse-llvm: %s: killed by signal %d\n",
+				jobs[i].file, WTERMSIG(jobs[i].status));
+		else
+			fprintf(stderr, "sparse-llvm: %s failed\n", jobs[i].file);
+		unlink(jobs[i].out);
+		failed = 1;
+	}
+	free(jobs);
+
+	return failed;
+}
+
 int main(int argc, char **argv)
 {
 	struct string_list *filelist = NULL;
 	struct symbol_list *symlist;
 	LLVMModuleRef module;
+	const char *dir = NULL;
+	bool text = false;
+	int nr_jobs = 1;
 	char *file;
 
+	while (argc > 1) {
+		if (!strcmp(argv[1], "-j") && argc > 2) {
+			nr_jobs = atoi(argv[2]);
+		} else if (!strcmp(argv[1], "-o") && argc > 2) {
+			dir = argv[2];
+		} else if (!strcmp(argv[1], "-S")) {
+			text = true;
+			argv[1] = argv[0];
+			argc--;
+			argv++;
+			continue;
+		} else {
+			break;
+		}
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+	if (nr_jobs < 1)
+		nr_jobs = 1;
+
 	symlist = sparse_initialize(argc, argv, &filelist);
 
+	if (dir)
+		return emit_files(symlist, filelist, dir, nr_jobs, text);
+
 	module = LLVMModuleCreateWithName("sparse");
 	set_target(module);
 
@@ -1161,7 +1385,13 @@ int main(int argc, char **argv)
 
 	LLVMVerifyModule(module, LLVMPrintMessageAction, NULL);
 
-	LLVMWriteBitcodeToFD(module, STDOUT_FILENO, 0, 0);
+	if (text) {
+		char *ir = LLVMPrintModuleToString(module);
+
+		fputs(ir, stdout);
+		LLVMDisposeMessage(ir);
+	} else
+		LLVMWriteBitcodeToFD(module, STDOUT_FILENO, 0, 0);
 
 	LLVMDisposeModule(module);
 
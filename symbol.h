@@ -162,6 +162,10 @@ struct symbol {
 			struct token *expansion;
 			struct token *arglist;
 			struct scope *used_in;
+			struct token *cached_expansion;
+			struct symbol_list *cache_deps;
+			unsigned int cache_generation;
+			unsigned int define_generation;
 		};
 		struct /* NS_PREPROCESSOR */ {
 			int (*handler)(struct stream *, struct token **, struct token *);
@@ -188,6 +192,7 @@ struct symbol {
 			struct symbol_list *symbol_list;
 			struct statement *inline_stmt;
 			struct symbol_list *inline_symbol_list;
+			struct token *lazy_body;
 			struct expression *initializer;
 			struct entrypoint *ep;
 			long long value;		/* Initial value */
@@ -30,6 +30,7 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/time.h>
 
 #include "token.h"
 #include "symbol.h"
@@ -37,13 +38,33 @@
 int main(int argc, char **argv)
 {
 	struct string_list *filelist = NULL;
+	struct timeval start, stop;
+	double secs;
 	char *file;
 
+	/* --bench only counts the tokens and reports how fast that was */
+	if (argc > 1 && !strcmp(argv[1], "--bench")) {
+		preprocess_bench = 1;
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	preprocess_only = 1;
 	sparse_initialize(argc, argv, &filelist);
+	gettimeofday(&start, NULL);
 	FOR_EACH_PTR_NOTAG(filelist, file) {
 		sparse(file);
 	} END_FOR_EACH_PTR_NOTAG(file);
+	gettimeofday(&stop, NULL);
+	if (preprocess_bench) {
+		secs = (stop.tv_sec - start.tv_sec) +
+		       (stop.tv_usec - start.tv_usec) / 1000000.0;
+		printf("%llu tokens in %.3f seconds, %.0f tokens/sec\n",
+		       preprocessed_tokens, secs,
+		       secs ? preprocessed_tokens / secs : 0);
+		return 0;
+	}
 	show_identifier_stats();
 	return 0;
 }
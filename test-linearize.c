@@ -29,6 +29,7 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/time.h>
 
 #include "lib.h"
 #include "allocate.h"
@@ -38,6 +39,9 @@
 #include "expression.h"
 #include "linearize.h"
 
+static int bench;
+static unsigned long nr_entrypoints;
+
 static void clean_up_symbols(struct symbol_list *list)
 {
 	struct symbol *sym;
@@ -47,7 +51,10 @@ static void clean_up_symbols(struct symbol_list *list)
 
 		expand_symbol(sym);
 		ep = linearize_symbol(sym);
-		if (ep)
+		if (!ep)
+			continue;
+		nr_entrypoints++;
+		if (!bench)
 			show_entry(ep);
 	} END_FOR_EACH_PTR(sym);
 }
@@ -55,11 +62,26 @@ static void clean_up_symbols(struct symbol_list *list)
 int main(int argc, char **argv)
 {
 	struct string_list *filelist = NULL;
+	struct timeval start, stop;
 	char *file;
 
+	/* --bench doesn't print anything, it only reports how long it took */
+	if (argc > 1 && !strcmp(argv[1], "--bench")) {
+		bench = 1;
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	clean_up_symbols(sparse_initialize(argc, argv, &filelist));
+	gettimeofday(&start, NULL);
 	FOR_EACH_PTR_NOTAG(filelist, file) {
 		clean_up_symbols(sparse(file));
 	} END_FOR_EACH_PTR_NOTAG(file);
+	gettimeofday(&stop, NULL);
+	if (bench)
+		printf("%lu functions in %.3f seconds\n", nr_entrypoints,
+		       (stop.tv_sec - start.tv_sec) +
+		       (stop.tv_usec - start.tv_usec) / 1000000.0);
 	return 0;
 }
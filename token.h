@@ -232,7 +232,7 @@ extern void init_include_path(void);
 extern struct token *preprocess(struct token *);
 
 extern void store_all_tokens(struct token *token);
-extern struct token *pos_get_token(struct position pos);
+extern struct ident *pos_get_ident(struct position pos);
 extern char *pos_ident(struct position pos);
 
 extern void store_macro_pos(struct token *);
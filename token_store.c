@@ -22,156 +22,175 @@
  * THE SOFTWARE.
  */
 
+/*
+ * The token store remembers where the identifiers of each file were before
+ * the preprocessor got to them, so checks can look at what was written in
+ * the source (for example an "#endif" or a macro name) at a given position.
+ *
+ * Only identifiers are kept and they are kept in a compact form: an array
+ * of (stream, line, column, ident) records sorted by position, where the
+ * ident is an index into a table of the distinct identifiers seen.  The
+ * tokens themselves are not copied.
+ */
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include "lib.h"
-#include "parse.h"
-#include "allocate.h"
-
-struct line {
-	struct position pos;
-	struct line *prev;
-	struct token *token;
-	struct line *next;
+#include "token.h"
+
+struct stored_ident {
+	unsigned int stream:14,
+		     pos:10;
+	unsigned int line;
+	uint32_t ident;
 };
 
-__ALLOCATOR(struct token, "token store", perm_token);
-ALLOCATOR(line, "line of tokens");
+static struct stored_ident *stored;
+static unsigned int nr_stored, stored_alloc;
+static int stored_sorted = 1;
 
-static struct token *copy_token(struct token *token)
+static struct ident **idents;
+static unsigned int nr_idents, idents_alloc;
+static uint32_t *ident_hash;
+static unsigned int ident_hash_size;
+
+static unsigned int hash_ident_ptr(struct ident *ident)
 {
-	struct token *new;
+	uintptr_t p = (uintptr_t)ident;
 
-	new = __alloc_perm_token(0);
-	memcpy(new, token, sizeof(*token));
-	new->next = NULL;
-	return new;
+	return (p >> 4) ^ (p >> 16);
 }
 
-static struct line *cursor;
-
-static void find_line(struct position pos)
+static void grow_ident_hash(void)
 {
-	if (!cursor)
-		return;
-	if (pos.line == cursor->pos.line)
-		return;
-	if (pos.line < cursor->pos.line) {
-		if (!cursor->prev)
-			return;
-		cursor = cursor->prev;
-		find_line(pos);
-		return;
+	unsigned int i, h;
+
+	free(ident_hash);
+	ident_hash_size = ident_hash_size ? ident_hash_size * 2 : 1024;
+	ident_hash = malloc(ident_hash_size * sizeof(*ident_hash));
+	if (!ident_hash)
+		die("out of memory");
+	memset(ident_hash, 0xff, ident_hash_size * sizeof(*ident_hash));
+
+	for (i = 0; i < nr_idents; i++) {
+		h = hash_ident_ptr(idents[i]) & (ident_hash_size - 1);
+		while (ident_hash[h] != UINT32_MAX)
+			h = (h + 1) & (ident_hash_size - 1);
+		ident_hash[h] = i;
 	}
-	if (!cursor->next)
-		return;
-	if (pos.line < cursor->next->pos.line)
-		return;
-	cursor = cursor->next;
-	find_line(pos);
 }
 
-static void insert_into_line(struct token **current, struct token *new)
+static uint32_t ident_index(struct ident *ident)
 {
-	if (!*current) {
-		*current = new;
-		return;
-	}
+	unsigned int h;
 
-	if (new->pos.pos < (*current)->pos.pos) {
-		new->next = *current;
-		*current = new;
-		return;
-	}
+	if (nr_idents * 2 >= ident_hash_size)
+		grow_ident_hash();
 
-	if (new->pos.pos == (*current)->pos.pos)
-		return;
+	h = hash_ident_ptr(ident) & (ident_hash_size - 1);
+	while (ident_hash[h] != UINT32_MAX) {
+		if (idents[ident_hash[h]] == ident)
+			return ident_hash[h];
+		h = (h + 1) & (ident_hash_size - 1);
+	}
 
-	insert_into_line(&(*current)->next, new);
+	if (nr_idents == idents_alloc) {
+		idents_alloc = idents_alloc ? idents_alloc * 2 : 1024;
+		idents = realloc(idents, idents_alloc * sizeof(*idents));
+		if (!idents)
+			die("out of memory");
+	}
+	idents[nr_idents] = ident;
+	ident_hash[h] = nr_idents;
+	return nr_idents++;
 }
 
-static void store_token(struct token *token)
+static int compare_pos(unsigned int stream, unsigned int line, unsigned int pos,
+		       const struct stored_ident *s)
 {
-	token = copy_token(token);
+	if (stream != s->stream)
+		return stream < s->stream ? -1 : 1;
+	if (line != s->line)
+		return line < s->line ? -1 : 1;
+	if (pos != s->pos)
+		return pos < s->pos ? -1 : 1;
+	return 0;
+}
 
-	find_line(token->pos);
+static int compare_stored(const void *_a, const void *_b)
+{
+	const struct stored_ident *a = _a, *b = _b;
 
-	if (!cursor) {
-		cursor = __alloc_line(0);
-		cursor->pos = token->pos;
-		cursor->token = token;
-		return;
-	}
+	return compare_pos(a->stream, a->line, a->pos, b);
+}
 
-	if (token->pos.line < cursor->pos.line) {
-		cursor->prev = __alloc_line(0);
-		cursor->prev->next = cursor;
-		cursor = cursor->prev;
-		cursor->pos = token->pos;
-		cursor->token = token;
-		return;
-	}
+static void store_ident(struct token *token)
+{
+	struct stored_ident *s;
 
-	if (token->pos.line == cursor->pos.line) {
-		insert_into_line(&cursor->token, token);
-		return;
+	if (nr_stored == stored_alloc) {
+		stored_alloc = stored_alloc ? stored_alloc * 2 : 4096;
+		stored = realloc(stored, stored_alloc * sizeof(*stored));
+		if (!stored)
+			die("out of memory");
 	}
 
-	cursor->next = __alloc_line(0);
-	cursor->next->prev = cursor;
-	cursor = cursor->next;
-	cursor->pos = token->pos;
-	cursor->token = token;
+	s = &stored[nr_stored];
+	s->stream = token->pos.stream;
+	s->line = token->pos.line;
+	s->pos = token->pos.pos;
+	s->ident = ident_index(token->ident);
+
+	/*
+	 * The tokenizer hands us the tokens in order so this is almost always
+	 * an append.  Sort lazily if it isn't.
+	 */
+	if (nr_stored && compare_stored(s, s - 1) < 0)
+		stored_sorted = 0;
+	nr_stored++;
 }
 
 void store_all_tokens(struct token *token)
 {
 	while (token_type(token) != TOKEN_STREAMEND) {
-		store_token(token);
+		if (token_type(token) == TOKEN_IDENT)
+			store_ident(token);
 		token = token->next;
 	}
 }
 
-struct token *first_token_from_line(struct position pos)
+struct ident *pos_get_ident(struct position pos)
 {
-	find_line(pos);
-
-	if (!cursor)
-		return NULL;
-
-	if (cursor->pos.stream != pos.stream)
-		return NULL;
-	if (cursor->pos.line != pos.line)
-		return NULL;
+	unsigned int lo = 0, hi;
+	int cmp;
 
-	return cursor->token;
-}
+	if (!stored_sorted) {
+		qsort(stored, nr_stored, sizeof(*stored), compare_stored);
+		stored_sorted = 1;
+	}
 
-struct token *pos_get_token(struct position pos)
-{
-	struct token *token;
-
-	token = first_token_from_line(pos);
-	while (token) {
-		if (pos.pos == token->pos.pos)
-			return token;
-		if (pos.pos < token->pos.pos)
-			return NULL;
-		token = token->next;
+	hi = nr_stored;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		cmp = compare_pos(pos.stream, pos.line, pos.pos, &stored[mid]);
+		if (cmp == 0)
+			return idents[stored[mid].ident];
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
 	}
 	return NULL;
 }
 
 char *pos_ident(struct position pos)
 {
-	struct token *token;
+	struct ident *ident;
 
-	token = pos_get_token(pos);
-	if (!token)
-		return NULL;
-	if (token_type(token) != TOKEN_IDENT)
+	ident = pos_get_ident(pos);
+	if (!ident)
 		return NULL;
-	return token->ident->name;
+	return ident->name;
 }
-
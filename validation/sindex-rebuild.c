@@ -0,0 +1,20 @@
+/*
+ * The code is in sindex_rebuild.sh.
+ *
+ * check-name: sindex incremental rebuild
+ * check-command: validation/sindex_rebuild.sh
+ *
+ * check-output-start
+first build:
+a.c
+b.c
+c.c
+d.c
+foo.h changed:
+a.c
+b.c
+nothing changed:
+search baz:
+foo.h:2:19 g def baz
+ * check-output-end
+ */
@@ -0,0 +1,33 @@
+#!/bin/sh
+
+#
+# Builds an index of a few files, changes a header and builds it again.
+# "sindex build -v" prints the files it indexes so the second build should
+# only print the files which include the header and the third nothing.
+#
+
+SINDEX=$(cd $(dirname $0)/.. && pwd)/sindex
+TMP=$(mktemp -d)
+
+trap "rm -rf $TMP" EXIT
+cd $TMP
+
+printf 'int foo(void);\n' > foo.h
+printf 'int bar(void);\n' > bar.h
+printf '#include "foo.h"\nint a(void) { return foo(); }\n' > a.c
+printf '#include "foo.h"\n#include "bar.h"\nint b(void) { return foo() + bar(); }\n' > b.c
+printf '#include "bar.h"\nint c(void) { return bar(); }\n' > c.c
+printf 'int d(void) { return 0; }\n' > d.c
+
+echo "first build:"
+$SINDEX build -j2 -v a.c b.c c.c d.c
+
+printf 'static inline int baz(void) { return 0; }\n' >> foo.h
+echo "foo.h changed:"
+$SINDEX build -j2 -v a.c b.c c.c d.c
+
+echo "nothing changed:"
+$SINDEX build -j2 -v a.c b.c c.c d.c
+
+echo "search baz:"
+$SINDEX search baz
@@ -0,0 +1,47 @@
+struct foo {
+	int a;
+	int *p;
+};
+
+static int counter;
+
+static inline int get_a(struct foo *p)
+{
+	if (!p)
+		return -1;
+	return p->a;
+}
+
+int func1(struct foo *p)
+{
+	if (p)
+		counter++;
+	return p->a;
+}
+
+int func2(struct foo *p)
+{
+	int a = get_a(p);
+
+	if (a < 0)
+		return a;
+	return p->a;
+}
+
+int func3(int x)
+{
+	int buf[10];
+
+	if (x > 10)
+		return 0;
+	return buf[x];
+}
+/*
+ * check-name: smatch --function-cache
+ * check-command: validation/smatch_compare.sh cache sm_function_cache.c --spammy
+ *
+ * check-output-start
+sm_function_cache.c:19 func1() error: we previously assumed 'p' could be null (see line 17)
+sm_function_cache.c:37 func3() error: buffer overflow 'buf' 10 <= 10
+ * check-output-end
+ */
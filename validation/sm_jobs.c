@@ -0,0 +1,65 @@
+struct foo {
+	int a;
+};
+
+#define bump(x) ((x)++ + (x)++)
+
+static inline int get_a(struct foo *p)
+{
+	int a = p->a; a++;
+	return a;
+}
+
+void func1(struct foo *p)
+{
+	if (p)
+		p->a = 1;
+	p->a = 2;
+}
+
+void func2(struct foo *p)
+{
+	int x;
+
+	if (get_a(p))
+		x = 1;
+	p->a = x;
+}
+
+void func3(struct foo *p)
+{
+	p->a = 1;
+	if (!p)
+		return;
+}
+
+void func4(struct foo *p)
+{
+	int y;
+
+	if (p)
+		y = 1;
+	p->a = y;
+}
+
+int func5(struct foo *p)
+{
+	int x = 0;
+
+	if (get_a(p))
+		return bump(x);
+	return 0;
+}
+/*
+ * check-name: smatch --jobs=<n>
+ * check-command: validation/smatch_compare.sh jobs sm_jobs.c --spammy
+ *
+ * check-output-start
+sm_jobs.c:17 func1() error: we previously assumed 'p' could be null (see line 15)
+sm_jobs.c:26 func2() error: uninitialized symbol 'x'.
+sm_jobs.c:32 func3() warn: variable dereferenced before check 'p' (see line 31)
+sm_jobs.c:42 func4() error: uninitialized symbol 'y'.
+sm_jobs.c:42 func4() error: we previously assumed 'p' could be null (see line 40)
+sm_jobs.c:50 func5() warn: side effect in macro 'bump' doing 'x++'
+ * check-output-end
+ */
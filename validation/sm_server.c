@@ -0,0 +1,47 @@
+_spin_lock(int name);
+_spin_unlock(int name);
+
+int a, b, c;
+
+int func(void)
+{
+	int mylock = 1;
+	int mylock2 = 1;
+	int mylock3 = 1;
+
+	if (a) {
+		return;
+	}
+
+	_spin_lock(mylock);
+	_spin_unlock(mylock);
+
+	if (b) {
+		_spin_unlock(mylock2);
+		return;
+	}
+
+	if (c)
+		_spin_lock(mylock3);
+	return;
+}
+
+void func2(int *p)
+{
+	if (p)
+		a = 1;
+	*p = 2;
+}
+/*
+ * check-name: smatch --server
+ * check-command: validation/smatch_compare.sh server sm_server.c --project=kernel --spammy
+ *
+ * check-output-start
+sm_server.c:26 func() warn: 'spin_lock:mylock3' is sometimes locked here and sometimes unlocked.
+sm_server.c:26 func() warn: inconsistent returns 'spin_lock:mylock2'.
+  Locked on:   line 13
+               line 26
+  Unlocked on: line 21
+sm_server.c:33 func2() error: we previously assumed 'p' could be null (see line 31)
+ * check-output-end
+ */
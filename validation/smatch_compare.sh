@@ -0,0 +1,61 @@
+#!/bin/sh
+
+#
+# Runs smatch on a file the normal way and prints the output, then runs it
+# a different way and prints the difference if the output isn't the same.
+# That way the test's check-output is the normal output and any difference
+# makes it fail.
+#
+#   smatch_compare.sh jobs <file> [smatch options]    --jobs=3
+#   smatch_compare.sh cache <file> [smatch options]   a cold and a warm
+#                                                      --function-cache
+#   smatch_compare.sh server <file> [smatch options]  the diagnostics from
+#                                                      --server
+#
+
+SMATCH=$(dirname $0)/../smatch
+MODE=$1
+FILE=$2
+shift 2
+TMP=$(mktemp -d)
+
+trap "rm -rf $TMP" EXIT
+
+# turns the JSON from --server back into the normal output
+server_to_text()
+{
+    sed -e 's/^.*"diagnostics": \[//' -e 's/\]}$//' \
+        -e 's/}, {"file": /}\n{"file": /g' |
+    sed -E 's/^\{"file": "(.*)", "line": ([0-9]+), "function": "(.*)", "severity": "[a-z]+", "message": "(.*)"\}$/\1:\2 \3() \4/' |
+    sed -e 's/\\n/\n/g' -e 's/\\t/\t/g' -e 's/\\"/"/g' -e 's/\\\\/\\/g' |
+    grep -v '^$'
+}
+
+$SMATCH "$@" $FILE > $TMP/expected 2>&1
+cat $TMP/expected
+
+case $MODE in
+jobs)
+    $SMATCH --jobs=3 "$@" $FILE > $TMP/got 2>&1
+    ;;
+cache)
+    $SMATCH --function-cache=$TMP/cache "$@" $FILE > $TMP/cold 2>&1
+    if ! cmp -s $TMP/expected $TMP/cold ; then
+        echo "cold --function-cache output differs:"
+        diff $TMP/expected $TMP/cold
+    fi
+    $SMATCH --function-cache=$TMP/cache "$@" $FILE > $TMP/got 2>&1
+    ;;
+server)
+    printf 'check 0 %s\nquit\n' $FILE | $SMATCH --server "$@" | server_to_text > $TMP/got
+    ;;
+*)
+    echo "unknown mode $MODE"
+    exit 1
+    ;;
+esac
+
+if ! cmp -s $TMP/expected $TMP/got ; then
+    echo "$MODE output differs:"
+    diff $TMP/expected $TMP/got
+fi